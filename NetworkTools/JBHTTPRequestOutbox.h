@@ -0,0 +1,101 @@
+//
+//  JBHTTPRequestOutbox.h
+//  JBNetworking
+//
+//  Created by agent on 2026/10/19.
+//  Copyright © 2026年 agent. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class JBHTTPSessionManager;
+@class JBNetworkReachabilityManager;
+
+/**
+ 离线发件箱<需要自己创建, 默认不开启>
+
+ 写请求(POST, PUT, PATCH, DELETE)先追加到一个带校验和的日志文件里, 网络恢复以后按批次通过`JBHTTPSessionManager`重放
+ 每个请求带一个幂等键, 服务器可以根据幂等键去重, 所以重放多次也不会重复写入
+ 日志只追加不修改, 发送成功的请求追加一条确认记录, 确认记录多了以后压缩日志
+ */
+@interface JBHTTPRequestOutbox : NSObject
+
+/// 用来重放请求的manager
+@property (readonly, nonatomic, strong) JBHTTPSessionManager *sessionManager;
+
+/// 网络状态的来源, 默认是sessionManager的reachabilityManger
+@property (readonly, nonatomic, strong) JBNetworkReachabilityManager *reachabilityManager;
+
+/// 日志文件的路径
+@property (readonly, nonatomic, copy) NSURL *journalURL;
+
+/// 每批重放的请求个数, 默认20
+@property (nonatomic, assign) NSUInteger replayBatchSize;
+
+/// 同时在途的重放请求上限, 默认4
+@property (nonatomic, assign) NSUInteger maximumConcurrentReplayCount;
+
+/// 网络状态改变以后等待多久再重放<去抖>, 默认1秒
+@property (nonatomic, assign) NSTimeInterval reachabilityDebounceInterval;
+
+/// 重放失败以后第一次重试的等待时间, 之后每次翻倍, 默认2秒
+@property (nonatomic, assign) NSTimeInterval minimumRetryInterval;
+
+/// 重试等待时间的上限, 默认300秒<服务器返回的 `Retry-After` 不受这个限制>
+@property (nonatomic, assign) NSTimeInterval maximumRetryInterval;
+
+/// 日志中失效的记录达到多少条的时候压缩日志, 默认64
+@property (nonatomic, assign) NSUInteger compactionThreshold;
+
+/// 幂等键使用的请求头, 默认 `Idempotency-Key`
+@property (nonatomic, copy) NSString *idempotencyKeyHeaderField;
+
+/// 还没有发送成功的请求个数
+@property (readonly, nonatomic, assign) NSUInteger pendingRequestCount;
+
+/// 使用sessionManager自带的网络状态
+- (instancetype)initWithSessionManager:(JBHTTPSessionManager *)sessionManager
+                            journalURL:(NSURL *)journalURL;
+
+/// 默认初始化方法, reachabilityManager可以注入自己的网络状态来源
+- (instancetype)initWithSessionManager:(JBHTTPSessionManager *)sessionManager
+                   reachabilityManager:(JBNetworkReachabilityManager *)reachabilityManager
+                            journalURL:(NSURL *)journalURL NS_DESIGNATED_INITIALIZER;
+
+/// 让默认的init方法无效化
+- (instancetype)init NS_UNAVAILABLE;
+
+
+/**
+ 把写请求记入日志, 网络可用的时候马上开始重放
+
+ @param method 只支持 "POST" "PUT" "PATCH" "DELETE"
+ @param URLString 相对于sessionManager的baseURL的地址
+ @param parameters 请求参数, 需要遵守NSCoding
+ @param error 方法不支持, 地址无效, 参数没法序列化或者写日志失败的错误
+ @return 请求的幂等键, 失败返回nil
+ */
+- (NSString *)enqueueRequestWithMethod:(NSString *)method
+                             URLString:(NSString *)URLString
+                            parameters:(id)parameters
+                                 error:(NSError * __autoreleasing *)error;
+
+/// 开始监听网络状态, 网络恢复以后自动重放<不会替reachabilityManager开始监测>
+- (void)startMonitoring;
+
+/// 停止监听网络状态
+- (void)stopMonitoring;
+
+/// 不管网络状态和重试的等待时间, 立即开始重放
+- (void)replayPendingRequests;
+
+/// 立即压缩日志, 只保留还没有发送成功的请求
+- (void)compactJournal;
+
+/// 单个请求重放结束的回调<服务器已经处理了, 不会再重放>, 在sessionManager的completionQueue上回调
+- (void)setRequestDidReplayBlock:(void (^)(NSString *idempotencyKey, NSURLResponse *response, id responseObject, NSError *error))block;
+
+@end
+
+/// 发件箱的错误域
+FOUNDATION_EXPORT NSString * const JBHTTPRequestOutboxErrorDomain;
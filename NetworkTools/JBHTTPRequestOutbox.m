@@ -0,0 +1,698 @@
+//
+//  JBHTTPRequestOutbox.m
+//  JBNetworking
+//
+//  Created by agent on 2026/10/19.
+//  Copyright © 2026年 agent. All rights reserved.
+//
+
+#import "JBHTTPRequestOutbox.h"
+#import "JBHTTPSessionManager.h"
+#import "JBNetworkReachabilityManager.h"
+
+#import <fcntl.h>
+#import <unistd.h>
+#import <zlib.h>
+
+NSString * const JBHTTPRequestOutboxErrorDomain = @"JBHTTPRequestOutboxErrorDomain";
+
+/// 每条记录开头的标记 'JBOX'
+static uint32_t const JBHTTPRequestOutboxRecordMagic = 0x4A424F58;
+
+/// 单条记录的长度上限, 防止损坏的长度字段越界
+static uint32_t const JBHTTPRequestOutboxMaximumRecordLength = 16 * 1024 * 1024;
+
+static void * JBHTTPRequestOutboxReachabilityContext = &JBHTTPRequestOutboxReachabilityContext;
+
+static NSString * const JBHTTPRequestOutboxIdempotencyKey = @"idempotencyKey";
+static NSString * const JBHTTPRequestOutboxMethodKey = @"method";
+static NSString * const JBHTTPRequestOutboxURLStringKey = @"URLString";
+static NSString * const JBHTTPRequestOutboxParametersKey = @"parameters";
+
+/// 日志记录的类型
+typedef NS_ENUM(uint32_t, JBHTTPRequestOutboxRecordType) {
+    JBHTTPRequestOutboxRecordTypeRequest     = 1,
+    JBHTTPRequestOutboxRecordTypeAcknowledge = 2
+};
+
+/// 日志记录的头部, 后面紧跟length个字节的内容<请求是归档的字典, 确认是幂等键的UTF8>
+typedef struct {
+    uint32_t magic;
+    uint32_t type;
+    uint32_t length;
+    uint32_t checksum;
+} JBHTTPRequestOutboxRecordHeader;
+
+typedef void (^JBHTTPRequestOutboxRequestDidReplayBlock)(NSString *idempotencyKey, NSURLResponse *response, id responseObject, NSError *error);
+
+/// CRC32校验和
+static uint32_t JBHTTPRequestOutboxChecksum(const void *bytes, uint32_t length) {
+    return (uint32_t)crc32(crc32(0L, Z_NULL, 0), bytes, length);
+}
+
+/// 拼接一条完整的记录 <头部 + 内容>
+static NSData * JBHTTPRequestOutboxRecordData(JBHTTPRequestOutboxRecordType type, NSData *payload) {
+    JBHTTPRequestOutboxRecordHeader header;
+    header.magic = JBHTTPRequestOutboxRecordMagic;
+    header.type = type;
+    header.length = (uint32_t)payload.length;
+    header.checksum = JBHTTPRequestOutboxChecksum(payload.bytes, header.length);
+
+    NSMutableData *record = [NSMutableData dataWithCapacity:sizeof(header) + payload.length];
+    [record appendBytes:&header length:sizeof(header)];
+    [record appendData:payload];
+
+    return record;
+}
+
+/// 是否需要再次重放<网络层的错误和服务器暂时不可用>, 其他结果说明服务器已经处理过这个请求了
+static BOOL JBHTTPRequestOutboxShouldRetry(NSURLResponse *response, NSError *error) {
+    // 参数没法序列化或者地址无效, 重放多少次都一样
+    if ([error.domain isEqualToString:JBURLRequestSerializationErrorDomain] || [error.domain isEqualToString:JBHTTPRequestOutboxErrorDomain]) {
+        return NO;
+    }
+
+    // 请求本身的问题, 不是网络暂时不可用
+    if ([error.domain isEqualToString:NSURLErrorDomain]) {
+        switch (error.code) {
+            case NSURLErrorBadURL:
+            case NSURLErrorUnsupportedURL:
+            case NSURLErrorAppTransportSecurityRequiresSecureConnection:
+            case NSURLErrorDataLengthExceedsMaximum:
+                return NO;
+            default:
+                return YES;
+        }
+    }
+
+    if (![response isKindOfClass:[NSHTTPURLResponse class]]) {
+        return YES;
+    }
+
+    NSInteger statusCode = ((NSHTTPURLResponse *)response).statusCode;
+    return statusCode == 408 || statusCode == 429 || statusCode >= 500;
+}
+
+/// 429和503的 `Retry-After`, 可以是秒数也可以是HTTP日期, 没有的时候返回0
+static NSTimeInterval JBHTTPRequestOutboxRetryAfterInterval(NSURLResponse *response) {
+    if (![response isKindOfClass:[NSHTTPURLResponse class]]) {
+        return 0;
+    }
+
+    NSHTTPURLResponse *HTTPResponse = (NSHTTPURLResponse *)response;
+    if (HTTPResponse.statusCode != 429 && HTTPResponse.statusCode != 503) {
+        return 0;
+    }
+
+    __block NSString *retryAfter = nil;
+    [HTTPResponse.allHeaderFields enumerateKeysAndObjectsUsingBlock:^(NSString *field, NSString *value, BOOL *stop) {
+        if ([field caseInsensitiveCompare:@"Retry-After"] == NSOrderedSame) {
+            retryAfter = [value stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+            *stop = YES;
+        }
+    }];
+
+    if (retryAfter.length == 0) {
+        return 0;
+    }
+
+    if ([retryAfter rangeOfCharacterFromSet:[[NSCharacterSet decimalDigitCharacterSet] invertedSet]].location == NSNotFound) {
+        return retryAfter.doubleValue;
+    }
+
+    static NSDateFormatter *formatter = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        formatter = [[NSDateFormatter alloc] init];
+        formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+        formatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+        formatter.dateFormat = @"EEE, dd MMM yyyy HH:mm:ss zzz";
+    });
+
+    NSDate *date = [formatter dateFromString:retryAfter];
+    return date ? MAX([date timeIntervalSinceNow], 0) : 0;
+}
+
+
+#pragma mark - JBHTTPRequestOutboxEntry
+
+/// 日志里一条还没有发送成功的请求
+@interface JBHTTPRequestOutboxEntry : NSObject
+@property (nonatomic, copy) NSString *idempotencyKey;
+@property (nonatomic, copy) NSString *method;
+@property (nonatomic, copy) NSString *URLString;
+@property (nonatomic, strong) id parameters;
+/// 完整的日志记录, 压缩的时候直接写回去, 不用重新归档
+@property (nonatomic, strong) NSData *record;
+@end
+
+@implementation JBHTTPRequestOutboxEntry
+@end
+
+
+#pragma mark - JBHTTPRequestOutbox
+
+@interface JBHTTPRequestOutbox ()
+@property (readwrite, nonatomic, strong) JBHTTPSessionManager *sessionManager;
+@property (readwrite, nonatomic, strong) JBNetworkReachabilityManager *reachabilityManager;
+@property (readwrite, nonatomic, copy) NSURL *journalURL;
+/// 日志和内存状态只在这个串行队列上修改
+@property (nonatomic, strong) dispatch_queue_t queue;
+/// 控制并发的时候会阻塞, 所以和queue分开
+@property (nonatomic, strong) dispatch_queue_t replayQueue;
+@property (nonatomic, assign) int journalFileDescriptor;
+@property (nonatomic, strong) NSMutableArray <JBHTTPRequestOutboxEntry *> *pendingEntries;
+/// 日志里已经失效的记录个数<确认记录和被确认的请求>
+@property (nonatomic, assign) NSUInteger obsoleteRecordCount;
+@property (nonatomic, assign) NSUInteger reachabilityGeneration;
+/// 连续重试失败的次数, 用来计算退避时间
+@property (nonatomic, assign) NSUInteger retryCount;
+/// 每次安排或者取消重试都加一, 过期的重试直接丢掉
+@property (nonatomic, assign) NSUInteger retryGeneration;
+@property (nonatomic, assign, getter = isWaitingForRetry) BOOL waitingForRetry;
+/// 等待时间是服务器用 `Retry-After` 指定的, 网络状态改变也不提前重放
+@property (nonatomic, assign) BOOL retryAfterSpecifiedByServer;
+@property (nonatomic, assign, getter = isReplaying) BOOL replaying;
+@property (nonatomic, assign, getter = isMonitoring) BOOL monitoring;
+@property (nonatomic, copy) JBHTTPRequestOutboxRequestDidReplayBlock requestDidReplay;
+@end
+
+@implementation JBHTTPRequestOutbox
+
+- (instancetype)initWithSessionManager:(JBHTTPSessionManager *)sessionManager journalURL:(NSURL *)journalURL {
+    return [self initWithSessionManager:sessionManager reachabilityManager:sessionManager.reachabilityManger journalURL:journalURL];
+}
+
+- (instancetype)initWithSessionManager:(JBHTTPSessionManager *)sessionManager reachabilityManager:(JBNetworkReachabilityManager *)reachabilityManager journalURL:(NSURL *)journalURL {
+    NSParameterAssert(sessionManager);
+    NSParameterAssert([journalURL isFileURL]);
+
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+
+    self.sessionManager = sessionManager;
+    self.reachabilityManager = reachabilityManager;
+    self.journalURL = journalURL;
+
+    self.replayBatchSize = 20;
+    self.maximumConcurrentReplayCount = 4;
+    self.reachabilityDebounceInterval = 1.0;
+    self.minimumRetryInterval = 2.0;
+    self.maximumRetryInterval = 300.0;
+    self.compactionThreshold = 64;
+    self.idempotencyKeyHeaderField = @"Idempotency-Key";
+
+    self.queue = dispatch_queue_create("jb_http_request_outbox_queue", DISPATCH_QUEUE_SERIAL);
+    self.replayQueue = dispatch_queue_create("jb_http_request_outbox_replay_queue", DISPATCH_QUEUE_SERIAL);
+
+    self.pendingEntries = [NSMutableArray array];
+    self.journalFileDescriptor = -1;
+
+    // 日志可能很大, 不在调用init的线程<通常是主线程>上读, 之后的操作都排在读完以后
+    dispatch_async(self.queue, ^{
+        [self loadJournal];
+    });
+
+    return self;
+}
+
+/// 让默认的init方法无效化
+- (instancetype)init NS_UNAVAILABLE {
+    return nil;
+}
+
+- (void)dealloc {
+    [self stopMonitoring];
+
+    if (_journalFileDescriptor >= 0) {
+        close(_journalFileDescriptor);
+    }
+}
+
+#pragma mark - 日志
+
+/// 读取日志<内存映射, 不把整个文件读进内存>, 恢复还没有确认的请求, 然后打开文件准备追加
+- (void)loadJournal {
+    unsigned long long validLength = 0;
+    unsigned long long journalLength = 0;
+    BOOL skippedCorruptedBytes = NO;
+
+    @autoreleasepool {
+        NSData *journal = [NSData dataWithContentsOfURL:self.journalURL options:NSDataReadingMappedAlways error:nil];
+        const uint8_t *bytes = journal.bytes;
+        NSUInteger length = journal.length;
+        NSUInteger offset = 0;
+
+        while (offset + sizeof(JBHTTPRequestOutboxRecordHeader) <= length) {
+            // 映射的内存不保证对齐, 拷贝出来再读
+            JBHTTPRequestOutboxRecordHeader header;
+            memcpy(&header, bytes + offset, sizeof(header));
+
+            NSUInteger recordLength = sizeof(header) + header.length;
+            const uint8_t *payloadBytes = bytes + offset + sizeof(header);
+            if (header.magic != JBHTTPRequestOutboxRecordMagic || header.length > JBHTTPRequestOutboxMaximumRecordLength || offset + recordLength > length || JBHTTPRequestOutboxChecksum(payloadBytes, header.length) != header.checksum) {
+                // 损坏的记录, 往后逐字节找下一条完整的记录, 不能丢掉后面的请求
+                offset += 1;
+                continue;
+            }
+
+            if (offset > validLength) {
+                skippedCorruptedBytes = YES;
+            }
+
+            NSData *payload = [NSData dataWithBytesNoCopy:(void *)payloadBytes length:header.length freeWhenDone:NO];
+            if (header.type == JBHTTPRequestOutboxRecordTypeRequest) {
+                JBHTTPRequestOutboxEntry *entry = [self entryWithPayload:payload];
+                if (entry) {
+                    entry.record = [NSData dataWithBytes:bytes + offset length:recordLength];
+                    [self.pendingEntries addObject:entry];
+                } else {
+                    self.obsoleteRecordCount += 1;
+                }
+            } else if (header.type == JBHTTPRequestOutboxRecordTypeAcknowledge) {
+                NSString *idempotencyKey = [[NSString alloc] initWithData:payload encoding:NSUTF8StringEncoding];
+                NSUInteger index = [self indexOfPendingEntryForIdempotencyKey:idempotencyKey];
+                if (index != NSNotFound) {
+                    [self.pendingEntries removeObjectAtIndex:index];
+                    self.obsoleteRecordCount += 1;
+                }
+                self.obsoleteRecordCount += 1;
+            } else {
+                self.obsoleteRecordCount += 1;
+            }
+
+            offset += recordLength;
+            validLength = offset;
+        }
+
+        journalLength = length;
+    }
+
+    // 中间有损坏的内容, 重写一份干净的日志; 重写失败也可以继续追加, 下次读取的时候还会跳过损坏的部分
+    if (skippedCorruptedBytes && [self performCompaction]) {
+        return;
+    }
+
+    self.journalFileDescriptor = open(self.journalURL.path.fileSystemRepresentation, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+
+    // 尾部是写了一半的记录<崩溃或者断电>, 截掉以后新追加的记录才能被读到
+    if (self.journalFileDescriptor >= 0 && validLength < journalLength) {
+        [self truncateJournalToLength:(off_t)validLength];
+    }
+}
+
+/// 截掉日志尾部, 截不掉的话后面追加的记录也读不出来, 干脆停止追加
+- (BOOL)truncateJournalToLength:(off_t)length {
+    if (ftruncate(self.journalFileDescriptor, length) == 0) {
+        return YES;
+    }
+
+    close(self.journalFileDescriptor);
+    self.journalFileDescriptor = -1;
+
+    return NO;
+}
+
+- (JBHTTPRequestOutboxEntry *)entryWithPayload:(NSData *)payload {
+    NSDictionary *request = nil;
+    @try {
+        request = [NSKeyedUnarchiver unarchiveObjectWithData:payload];
+    } @catch (NSException *exception) {
+        request = nil;
+    }
+
+    if (![request isKindOfClass:[NSDictionary class]] || !request[JBHTTPRequestOutboxIdempotencyKey]) {
+        return nil;
+    }
+
+    JBHTTPRequestOutboxEntry *entry = [[JBHTTPRequestOutboxEntry alloc] init];
+    entry.idempotencyKey = request[JBHTTPRequestOutboxIdempotencyKey];
+    entry.method = request[JBHTTPRequestOutboxMethodKey];
+    entry.URLString = request[JBHTTPRequestOutboxURLStringKey];
+    entry.parameters = request[JBHTTPRequestOutboxParametersKey];
+
+    return entry;
+}
+
+- (NSUInteger)indexOfPendingEntryForIdempotencyKey:(NSString *)idempotencyKey {
+    return [self.pendingEntries indexOfObjectPassingTest:^BOOL(JBHTTPRequestOutboxEntry *entry, NSUInteger idx, BOOL *stop) {
+        return [entry.idempotencyKey isEqualToString:idempotencyKey];
+    }];
+}
+
+/// 追加一条记录, 失败的时候把写了一半的内容截掉, 截不掉就停止追加
+- (BOOL)appendRecord:(NSData *)record synchronize:(BOOL)synchronize error:(NSError * __autoreleasing *)error {
+    int fileDescriptor = self.journalFileDescriptor;
+    off_t originalLength = fileDescriptor >= 0 ? lseek(fileDescriptor, 0, SEEK_END) : -1;
+
+    const uint8_t *bytes = record.bytes;
+    NSUInteger remaining = record.length;
+    while (fileDescriptor >= 0 && remaining > 0) {
+        ssize_t written = write(fileDescriptor, bytes, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        bytes += written;
+        remaining -= (NSUInteger)written;
+    }
+
+    if (remaining == 0 && (!synchronize || fsync(fileDescriptor) == 0)) {
+        return YES;
+    }
+
+    int code = fileDescriptor >= 0 ? errno : EBADF;
+    if (originalLength >= 0) {
+        [self truncateJournalToLength:originalLength];
+    }
+
+    if (error) {
+        *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:@{NSURLErrorKey: self.journalURL}];
+    }
+
+    return NO;
+}
+
+/// 重写日志, 只保留还没有确认的请求
+- (BOOL)performCompaction {
+    NSMutableData *journal = [NSMutableData data];
+    for (JBHTTPRequestOutboxEntry *entry in self.pendingEntries) {
+        [journal appendData:entry.record];
+    }
+
+    // 原子写入<先写临时文件再替换>, 中途崩溃旧的日志还是完整的
+    if (![journal writeToURL:self.journalURL options:NSDataWritingAtomic error:nil]) {
+        return NO;
+    }
+
+    if (self.journalFileDescriptor >= 0) {
+        close(self.journalFileDescriptor);
+    }
+    self.journalFileDescriptor = open(self.journalURL.path.fileSystemRepresentation, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    self.obsoleteRecordCount = 0;
+
+    return self.journalFileDescriptor >= 0;
+}
+
+- (void)compactJournalIfNeeded {
+    if (self.obsoleteRecordCount >= MAX(self.compactionThreshold, 1)) {
+        [self performCompaction];
+    }
+}
+
+- (void)compactJournal {
+    dispatch_async(self.queue, ^{
+        [self performCompaction];
+    });
+}
+
+- (NSUInteger)pendingRequestCount {
+    __block NSUInteger count = 0;
+    dispatch_sync(self.queue, ^{
+        count = self.pendingEntries.count;
+    });
+
+    return count;
+}
+
+#pragma mark - 入队
+
+- (NSString *)enqueueRequestWithMethod:(NSString *)method URLString:(NSString *)URLString parameters:(id)parameters error:(NSError *__autoreleasing *)error {
+    NSParameterAssert(method);
+    NSParameterAssert(URLString);
+
+    NSString *HTTPMethod = method.uppercaseString;
+    if (![[NSSet setWithObjects:@"POST", @"PUT", @"PATCH", @"DELETE", nil] containsObject:HTTPMethod]) {
+        if (error) {
+            NSDictionary *userInfo = @{NSLocalizedDescriptionKey: [NSString stringWithFormat:NSLocalizedStringFromTable(@"Outbox only accepts POST, PUT, PATCH and DELETE requests: %@", @"JBNetworking", nil), method]};
+            *error = [NSError errorWithDomain:JBHTTPRequestOutboxErrorDomain code:NSURLErrorUnsupportedURL userInfo:userInfo];
+        }
+        return nil;
+    }
+
+    // 先按重放时的方式构造一次请求, 发不出去的请求不写进日志, 否则每次启动都会重放失败
+    if (![self requestWithMethod:HTTPMethod URLString:URLString parameters:parameters error:error]) {
+        return nil;
+    }
+
+    JBHTTPRequestOutboxEntry *entry = [[JBHTTPRequestOutboxEntry alloc] init];
+    entry.idempotencyKey = [NSUUID UUID].UUIDString;
+    entry.method = HTTPMethod;
+    entry.URLString = URLString;
+    entry.parameters = parameters;
+
+    NSMutableDictionary *request = [NSMutableDictionary dictionary];
+    request[JBHTTPRequestOutboxIdempotencyKey] = entry.idempotencyKey;
+    request[JBHTTPRequestOutboxMethodKey] = entry.method;
+    request[JBHTTPRequestOutboxURLStringKey] = entry.URLString;
+    request[JBHTTPRequestOutboxParametersKey] = parameters;
+
+    NSData *payload = nil;
+    @try {
+        payload = [NSKeyedArchiver archivedDataWithRootObject:request];
+    } @catch (NSException *exception) {
+        if (error) {
+            *error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSCoderInvalidValueError userInfo:@{NSLocalizedFailureReasonErrorKey: exception.reason ?: @""}];
+        }
+        return nil;
+    }
+    entry.record = JBHTTPRequestOutboxRecordData(JBHTTPRequestOutboxRecordTypeRequest, payload);
+
+    __block BOOL success = NO;
+    __block NSError *journalError = nil;
+    dispatch_sync(self.queue, ^{
+        // 请求一定要落盘以后才算入队
+        success = [self appendRecord:entry.record synchronize:YES error:&journalError];
+        if (success) {
+            [self.pendingEntries addObject:entry];
+            [self replayNextBatchIfReachable];
+        }
+    });
+
+    if (!success) {
+        if (error) {
+            *error = journalError;
+        }
+        return nil;
+    }
+
+    return entry.idempotencyKey;
+}
+
+#pragma mark - 重放
+
+- (void)replayPendingRequests {
+    dispatch_async(self.queue, ^{
+        [self cancelRetry];
+        [self replayNextBatch];
+    });
+}
+
+- (void)replayNextBatchIfReachable {
+    // 没有开始监测的时候状态是Unknown, 也尝试发送; 等待重试的时候新入队的请求不马上发送
+    if (self.isWaitingForRetry || self.reachabilityManager.networkReachabilityStatus == JBNetworkReachabilityStatusNotConnect) {
+        return;
+    }
+
+    [self replayNextBatch];
+}
+
+/// 指数退避以后再重放, 服务器给了 `Retry-After` 就按服务器的时间
+- (void)scheduleRetryAfterInterval:(NSTimeInterval)retryAfterInterval {
+    NSTimeInterval interval = retryAfterInterval;
+    if (interval <= 0) {
+        interval = MIN(MAX(self.minimumRetryInterval, 0) * pow(2, MIN(self.retryCount, 16)), self.maximumRetryInterval);
+    }
+
+    self.retryCount += 1;
+    self.waitingForRetry = YES;
+    self.retryAfterSpecifiedByServer = retryAfterInterval > 0;
+    NSUInteger generation = ++self.retryGeneration;
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(interval * NSEC_PER_SEC)), self.queue, ^{
+        if (generation != self.retryGeneration) {
+            return;
+        }
+
+        self.waitingForRetry = NO;
+        [self replayNextBatchIfReachable];
+    });
+}
+
+/// 取消等待中的重试<网络状态改变或者手动重放的时候>
+- (void)cancelRetry {
+    self.retryGeneration += 1;
+    self.waitingForRetry = NO;
+    self.retryAfterSpecifiedByServer = NO;
+}
+
+/// 按顺序取出一批请求重放, 整批结束以后再取下一批, 遇到需要重试的请求就退避一段时间再重放
+- (void)replayNextBatch {
+    if (self.isReplaying) {
+        return;
+    }
+
+    NSUInteger batchSize = MIN(MAX(self.replayBatchSize, 1), self.pendingEntries.count);
+    NSArray <JBHTTPRequestOutboxEntry *> *batch = [self.pendingEntries subarrayWithRange:NSMakeRange(0, batchSize)];
+    if (batch.count == 0) {
+        [self compactJournalIfNeeded];
+        return;
+    }
+
+    self.replaying = YES;
+
+    dispatch_group_t group = dispatch_group_create();
+    dispatch_semaphore_t semaphore = dispatch_semaphore_create(MAX(self.maximumConcurrentReplayCount, 1));
+    __block BOOL shouldContinue = YES;
+    __block NSTimeInterval retryAfterInterval = 0;
+
+    for (JBHTTPRequestOutboxEntry *entry in batch) {
+        dispatch_group_enter(group);
+
+        dispatch_async(self.replayQueue, ^{
+            dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+
+            [self replayEntry:entry completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
+                dispatch_semaphore_signal(semaphore);
+
+                BOOL shouldRetry = JBHTTPRequestOutboxShouldRetry(response, error);
+                if (!shouldRetry && self.requestDidReplay) {
+                    self.requestDidReplay(entry.idempotencyKey, response, responseObject, error);
+                }
+
+                dispatch_async(self.queue, ^{
+                    if (shouldRetry) {
+                        shouldContinue = NO;
+                        retryAfterInterval = MAX(retryAfterInterval, JBHTTPRequestOutboxRetryAfterInterval(response));
+                    } else {
+                        [self acknowledgeEntry:entry];
+                    }
+
+                    dispatch_group_leave(group);
+                });
+            }];
+        });
+    }
+
+    dispatch_group_notify(group, self.queue, ^{
+        self.replaying = NO;
+
+        if (shouldContinue) {
+            self.retryCount = 0;
+            [self replayNextBatchIfReachable];
+        } else {
+            [self compactJournalIfNeeded];
+            [self scheduleRetryAfterInterval:retryAfterInterval];
+        }
+    });
+}
+
+- (void)replayEntry:(JBHTTPRequestOutboxEntry *)entry completionHandler:(void (^)(NSURLResponse *response, id responseObject, NSError *error))completionHandler {
+    JBHTTPSessionManager *manager = self.sessionManager;
+
+    NSError *serializationError = nil;
+    NSMutableURLRequest *request = [self requestWithMethod:entry.method URLString:entry.URLString parameters:entry.parameters error:&serializationError];
+    if (!request) {
+        dispatch_async(manager.completionQueue ?: dispatch_get_main_queue(), ^{
+            completionHandler(nil, nil, serializationError);
+        });
+        return;
+    }
+
+    // 服务器根据幂等键去重, 重放多次也只处理一次
+    [request setValue:entry.idempotencyKey forHTTPHeaderField:self.idempotencyKeyHeaderField];
+
+    NSURLSessionDataTask *dataTask = [manager dataTaskWithRequest:request uploadProgress:nil downloadProgress:nil completionHandler:completionHandler];
+    [dataTask resume];
+}
+
+/// 相对baseURL解析地址再交给requestSerializer, 地址解析不了返回错误, 不走requestSerializer里的断言
+- (NSMutableURLRequest *)requestWithMethod:(NSString *)method URLString:(NSString *)URLString parameters:(id)parameters error:(NSError * __autoreleasing *)error {
+    JBHTTPSessionManager *manager = self.sessionManager;
+
+    NSURL *URL = [NSURL URLWithString:URLString relativeToURL:manager.baseURL];
+    if (!URL.absoluteString) {
+        if (error) {
+            NSDictionary *userInfo = @{NSLocalizedDescriptionKey: [NSString stringWithFormat:NSLocalizedStringFromTable(@"Invalid outbox request URL: %@", @"JBNetworking", nil), URLString]};
+            *error = [NSError errorWithDomain:JBHTTPRequestOutboxErrorDomain code:NSURLErrorBadURL userInfo:userInfo];
+        }
+        return nil;
+    }
+
+    NSError *serializationError = nil;
+    NSMutableURLRequest *request = [manager.requestSerializer requestWithMethod:method URLString:URL.absoluteString parameters:parameters error:&serializationError];
+    if (!request || serializationError) {
+        if (error) {
+            *error = serializationError;
+        }
+        return nil;
+    }
+
+    return request;
+}
+
+/// 追加确认记录
+- (void)acknowledgeEntry:(JBHTTPRequestOutboxEntry *)entry {
+    // 确认记录丢了最多多重放一次, 有幂等键兜底, 所以不用fsync
+    [self appendRecord:JBHTTPRequestOutboxRecordData(JBHTTPRequestOutboxRecordTypeAcknowledge, [entry.idempotencyKey dataUsingEncoding:NSUTF8StringEncoding]) synchronize:NO error:nil];
+
+    [self.pendingEntries removeObjectIdenticalTo:entry];
+    self.obsoleteRecordCount += 2;
+}
+
+#pragma mark - 网络监听
+
+- (void)startMonitoring {
+    if (self.isMonitoring || !self.reachabilityManager) {
+        return;
+    }
+
+    self.monitoring = YES;
+    [self.reachabilityManager addObserver:self forKeyPath:NSStringFromSelector(@selector(networkReachabilityStatus)) options:NSKeyValueObservingOptionNew context:JBHTTPRequestOutboxReachabilityContext];
+
+    dispatch_async(self.queue, ^{
+        [self replayNextBatchIfReachable];
+    });
+}
+
+- (void)stopMonitoring {
+    if (!self.isMonitoring) {
+        return;
+    }
+
+    self.monitoring = NO;
+    [self.reachabilityManager removeObserver:self forKeyPath:NSStringFromSelector(@selector(networkReachabilityStatus)) context:JBHTTPRequestOutboxReachabilityContext];
+}
+
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary<NSKeyValueChangeKey,id> *)change context:(void *)context {
+    if (context != JBHTTPRequestOutboxReachabilityContext) {
+        [super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+        return;
+    }
+
+    // 状态在主线程改变, 去抖和重放都放到自己的队列上, 短时间内连续变化只在最后一次之后重放
+    dispatch_async(self.queue, ^{
+        NSUInteger generation = ++self.reachabilityGeneration;
+
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(self.reachabilityDebounceInterval * NSEC_PER_SEC)), self.queue, ^{
+            if (generation == self.reachabilityGeneration) {
+                // 换了网络, 网络错误的退避不再有意义
+                if (!self.retryAfterSpecifiedByServer) {
+                    [self cancelRetry];
+                    self.retryCount = 0;
+                }
+                [self replayNextBatchIfReachable];
+            }
+        });
+    });
+}
+
+- (void)setRequestDidReplayBlock:(void (^)(NSString *, NSURLResponse *, id, NSError *))block {
+    self.requestDidReplay = block;
+}
+
+@end
@@ -71,6 +71,38 @@
                         success:(void (^)(NSURLSessionDataTask *task, id responseObject))success
                         failure:(void (^)(NSURLSessionDataTask *task, NSError *error))failure;
 
+
+#pragma mark - 预热连接
+
+/// 预热的连接隔多久重新请求一次, 让连接不被服务器的keep-alive超时关掉, 默认25秒<预热中修改马上生效>
+@property (nonatomic, assign) NSTimeInterval preconnectKeepAliveInterval;
+
+/// 统计到连接信息的请求数<不包括预热请求, iOS10以上>
+@property (readonly, nonatomic, assign) NSUInteger countOfMeasuredRequests;
+
+/// 复用了已有连接的请求数<任何已有的连接, 不一定是预热打开的, 不包括预热请求, iOS10以上>
+@property (readonly, nonatomic, assign) NSUInteger countOfRequestsReusingConnection;
+
+/// 复用了预热请求用过的连接的请求数<按两端的地址和端口匹配, iOS13以上, 低版本一直是0>
+@property (readonly, nonatomic, assign) NSUInteger countOfRequestsReusingPreconnectedConnection;
+
+/// 提前打开并保持到baseURL的连接, 相当于 `preconnectURL:baseURL connectionCount:`
+- (void)preconnectWithConnectionCount:(NSUInteger)connectionCount;
+
+/**
+ 提前打开并保持到URL所在host的连接<DNS, TCP, TLS 都提前做完>
+
+ 用HEAD请求打开连接, 之后定时重新请求保持连接, 网络状态恢复以后重新预热
+ 连接数不会超过session配置的HTTPMaximumConnectionsPerHost, HTTP/2下同一个host只有一条连接
+
+ @param URL 预热的地址, 同一个host只保留最后一次设置的地址
+ @param connectionCount 目标连接数, 传0表示不再预热这个host
+ */
+- (void)preconnectURL:(NSURL *)URL connectionCount:(NSUInteger)connectionCount;
+
+/// 停止预热所有的host<已经打开的连接由系统按空闲超时关闭>
+- (void)stopPreconnecting;
+
 @end
 
 
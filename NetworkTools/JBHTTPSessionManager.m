@@ -22,8 +22,48 @@
 
 #import <UIKit/UIKit.h>
 
+/// 标记预热请求, 代理回调和统计连接复用的时候跳过
+static NSString * const JBHTTPSessionManagerPreconnectRequestKey = @"JBHTTPSessionManagerPreconnectRequestKey";
+
+static BOOL JBHTTPSessionManagerIsPreconnectTask(NSURLSessionTask *task) {
+    return task.originalRequest && [NSURLProtocol propertyForKey:JBHTTPSessionManagerPreconnectRequestKey inRequest:task.originalRequest] != nil;
+}
+
+static void * JBHTTPSessionManagerReachabilityContext = &JBHTTPSessionManagerReachabilityContext;
+
+/// 用两端的地址和端口标识一条连接<iOS13以上才有这些信息, 拿不到返回nil>
+static NSString * JBHTTPSessionManagerConnectionIdentifier(NSURLSessionTaskTransactionMetrics *transactionMetrics) {
+    // 用KVC取值, 低版本的SDK也能编译
+    if (![transactionMetrics respondsToSelector:NSSelectorFromString(@"localPort")]) {
+        return nil;
+    }
+    
+    id localAddress = [transactionMetrics valueForKey:@"localAddress"];
+    id localPort = [transactionMetrics valueForKey:@"localPort"];
+    id remoteAddress = [transactionMetrics valueForKey:@"remoteAddress"];
+    id remotePort = [transactionMetrics valueForKey:@"remotePort"];
+    if (!localPort || !remoteAddress || !remotePort) {
+        return nil;
+    }
+    
+    return [NSString stringWithFormat:@"%@:%@-%@:%@", localAddress ?: @"", localPort, remoteAddress, remotePort];
+}
+
 @interface JBHTTPSessionManager ()
 @property (nonatomic, strong) NSURL *baseURL;
+@property (readwrite, nonatomic, assign) NSUInteger countOfMeasuredRequests;
+@property (readwrite, nonatomic, assign) NSUInteger countOfRequestsReusingConnection;
+@property (readwrite, nonatomic, assign) NSUInteger countOfRequestsReusingPreconnectedConnection;
+@property (nonatomic, strong) NSLock *preconnectLock;
+/// 以 scheme://host:port 为key的预热地址和连接数
+@property (nonatomic, strong) NSMutableDictionary <NSString *, NSURL *> *preconnectURLs;
+@property (nonatomic, strong) NSMutableDictionary <NSString *, NSNumber *> *preconnectConnectionCounts;
+/// 预热请求用过的连接
+@property (nonatomic, strong) NSMutableSet <NSString *> *preconnectedConnectionIdentifiers;
+@property (nonatomic, strong) dispatch_source_t preconnectTimer;
+@property (nonatomic, strong) JBNetworkReachabilityManager *preconnectReachabilityManager;
+/// session已经失效, 不能再创建预热任务<在preconnectLock里读写>
+@property (nonatomic, assign, getter = isPreconnectSessionInvalidated) BOOL preconnectSessionInvalidated;
 @end;
 
 @implementation JBHTTPSessionManager
@@ -56,9 +96,19 @@
     self.requestSerializer = [JBHTTPRequestSerializer serializer];
     self.responseSerializer = [JBHTTPResponseSerializer serializer];
     
+    self.preconnectKeepAliveInterval = 25.0;
+    self.preconnectLock = [[NSLock alloc] init];
+    self.preconnectURLs = [NSMutableDictionary dictionary];
+    self.preconnectedConnectionIdentifiers = [NSMutableSet set];
+    self.preconnectConnectionCounts = [NSMutableDictionary dictionary];
+    
     return self;
 }
 
+- (void)dealloc {
+    [self stopPreconnecting];
+}
+
 
 - (void)setRequestSerializer:(JBHTTPRequestSerializer<JBURLRequestSerialization> *)requestSerializer {
     NSParameterAssert(requestSerializer);
@@ -191,6 +241,264 @@
 }
 
 
+#pragma mark - 预热连接
+
+- (void)preconnectWithConnectionCount:(NSUInteger)connectionCount {
+    NSParameterAssert(self.baseURL);
+    
+    [self preconnectURL:self.baseURL connectionCount:connectionCount];
+}
+
+- (void)preconnectURL:(NSURL *)URL connectionCount:(NSUInteger)connectionCount {
+    NSParameterAssert(URL.host);
+    
+    NSString *hostKey = [self preconnectHostKeyForURL:URL];
+    
+    [self.preconnectLock lock];
+    if (self.isPreconnectSessionInvalidated) {
+        [self.preconnectLock unlock];
+        return;
+    }
+    
+    if (connectionCount > 0) {
+        self.preconnectURLs[hostKey] = URL;
+        self.preconnectConnectionCounts[hostKey] = @(connectionCount);
+        [self startPreconnectMaintenance];
+    } else {
+        [self.preconnectURLs removeObjectForKey:hostKey];
+        [self.preconnectConnectionCounts removeObjectForKey:hostKey];
+        if (self.preconnectURLs.count == 0) {
+            [self stopPreconnectMaintenance];
+        }
+    }
+    [self.preconnectLock unlock];
+    
+    [self openConnectionsToURL:URL connectionCount:connectionCount];
+}
+
+- (void)stopPreconnecting {
+    [self.preconnectLock lock];
+    [self.preconnectURLs removeAllObjects];
+    [self.preconnectConnectionCounts removeAllObjects];
+    [self.preconnectedConnectionIdentifiers removeAllObjects];
+    [self stopPreconnectMaintenance];
+    [self.preconnectLock unlock];
+}
+
+/// 重新预热所有的host
+- (void)warmUpPreconnectedHosts {
+    [self.preconnectLock lock];
+    NSDictionary *URLs = [self.preconnectURLs copy];
+    NSDictionary *connectionCounts = [self.preconnectConnectionCounts copy];
+    [self.preconnectLock unlock];
+    
+    [URLs enumerateKeysAndObjectsUsingBlock:^(NSString *hostKey, NSURL *URL, BOOL *stop) {
+        [self openConnectionsToURL:URL connectionCount:[connectionCounts[hostKey] unsignedIntegerValue]];
+    }];
+}
+
+- (NSString *)preconnectHostKeyForURL:(NSURL *)URL {
+    return [NSString stringWithFormat:@"%@://%@:%@", URL.scheme.lowercaseString, URL.host.lowercaseString, URL.port ?: @""];
+}
+
+/// 同时发出多个HEAD请求, HTTP/1.1下每个并发的请求占一条连接, 超过上限的请求只会排队, 所以不多发
+- (void)openConnectionsToURL:(NSURL *)URL connectionCount:(NSUInteger)connectionCount {
+    NSUInteger maximumConnectionCount = (NSUInteger)MAX(self.session.configuration.HTTPMaximumConnectionsPerHost, 1);
+    
+    // 定时器的回调可能在stopPreconnecting之后还在跑, 在锁里确认还在预热这个host并且session没有失效再创建任务
+    [self.preconnectLock lock];
+    if (!self.isPreconnectSessionInvalidated && self.preconnectURLs[[self preconnectHostKeyForURL:URL]]) {
+        for (NSUInteger i = 0; i < MIN(connectionCount, maximumConnectionCount); i++) {
+            NSMutableURLRequest *request = [self.requestSerializer requestWithMethod:@"HEAD" URLString:URL.absoluteString parameters:nil error:nil];
+            if (!request) {
+                break;
+            }
+            
+            request.cachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+            [NSURLProtocol setProperty:@YES forKey:JBHTTPSessionManagerPreconnectRequestKey inRequest:request];
+            
+            // 直接在session上创建, 没有任务代理, 不发通知, 不走responseSerializer
+            NSURLSessionDataTask *dataTask = [self.session dataTaskWithRequest:request];
+            [dataTask resume];
+        }
+    }
+    [self.preconnectLock unlock];
+}
+
+/// 开始定时保持连接, 监听网络状态<调用的时候需要持有preconnectLock>
+- (void)startPreconnectMaintenance {
+    if (self.preconnectTimer) {
+        return;
+    }
+    
+    dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+    [self schedulePreconnectTimer:timer];
+    
+    __weak typeof(self) weakSelf = self;
+    dispatch_source_set_event_handler(timer, ^{
+        __strong typeof(weakSelf) strongSelf = weakSelf;
+        [strongSelf warmUpPreconnectedHosts];
+    });
+    dispatch_resume(timer);
+    self.preconnectTimer = timer;
+    
+    // 网络切换以后旧的连接都断了, 恢复以后重新预热
+    self.preconnectReachabilityManager = self.reachabilityManger;
+    [self.preconnectReachabilityManager addObserver:self forKeyPath:NSStringFromSelector(@selector(networkReachabilityStatus)) options:NSKeyValueObservingOptionNew context:JBHTTPSessionManagerReachabilityContext];
+}
+
+/// 按当前的preconnectKeepAliveInterval设置定时器, 从现在开始重新计时
+- (void)schedulePreconnectTimer:(dispatch_source_t)timer {
+    uint64_t interval = (uint64_t)(MAX(self.preconnectKeepAliveInterval, 1.0) * NSEC_PER_SEC);
+    dispatch_source_set_timer(timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)interval), interval, interval / 10);
+}
+
+- (void)setPreconnectKeepAliveInterval:(NSTimeInterval)preconnectKeepAliveInterval {
+    _preconnectKeepAliveInterval = preconnectKeepAliveInterval;
+    
+    // 已经在预热的话马上换成新的间隔
+    [self.preconnectLock lock];
+    if (self.preconnectTimer) {
+        [self schedulePreconnectTimer:self.preconnectTimer];
+    }
+    [self.preconnectLock unlock];
+}
+
+/// 停止定时和监听<调用的时候需要持有preconnectLock>
+- (void)stopPreconnectMaintenance {
+    if (!self.preconnectTimer) {
+        return;
+    }
+    
+    dispatch_source_cancel(self.preconnectTimer);
+    self.preconnectTimer = nil;
+    
+    [self.preconnectReachabilityManager removeObserver:self forKeyPath:NSStringFromSelector(@selector(networkReachabilityStatus)) context:JBHTTPSessionManagerReachabilityContext];
+    self.preconnectReachabilityManager = nil;
+}
+
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary<NSKeyValueChangeKey,id> *)change context:(void *)context {
+    if (context != JBHTTPSessionManagerReachabilityContext) {
+        [super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+        return;
+    }
+    
+    // 网络变了, 之前预热的连接都不能用了
+    [self.preconnectLock lock];
+    [self.preconnectedConnectionIdentifiers removeAllObjects];
+    [self.preconnectLock unlock];
+    
+    if ([object isReachable]) {
+        [self warmUpPreconnectedHosts];
+    }
+}
+
+- (void)invalidateSessionCancleTask:(BOOL)cancelPendingTasks {
+    // session失效以后不能再创建任务, 先标记再停止, 正在跑的定时器回调拿到锁以后也不会再创建
+    [self.preconnectLock lock];
+    self.preconnectSessionInvalidated = YES;
+    [self.preconnectLock unlock];
+    [self stopPreconnecting];
+    
+    [super invalidateSessionCancleTask:cancelPendingTasks];
+}
+
+#pragma mark - NSURLSessionTaskDelegate
+
+// 预热请求对使用者是不可见的, 下面这些回调直接按默认处理, 不调用使用者设置的block
+
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task willPerformHTTPRedirection:(NSHTTPURLResponse *)response newRequest:(NSURLRequest *)request completionHandler:(void (^)(NSURLRequest * _Nullable))completionHandler {
+    if (JBHTTPSessionManagerIsPreconnectTask(task)) {
+        if (completionHandler) {
+            completionHandler(request);
+        }
+        return;
+    }
+    
+    [super URLSession:session task:task willPerformHTTPRedirection:response newRequest:request completionHandler:completionHandler];
+}
+
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task didCompleteWithError:(NSError *)error {
+    if (JBHTTPSessionManagerIsPreconnectTask(task)) {
+        return;
+    }
+    
+    [super URLSession:session task:task didCompleteWithError:error];
+}
+
+- (void)URLSession:(NSURLSession *)session task:(NSURLSessionTask *)task didFinishCollectingMetrics:(NSURLSessionTaskMetrics *)metrics {
+    // 只看真正走网络的那次请求
+    NSURLSessionTaskTransactionMetrics *networkLoadMetrics = nil;
+    for (NSURLSessionTaskTransactionMetrics *transactionMetrics in metrics.transactionMetrics) {
+        if (transactionMetrics.resourceFetchType == NSURLSessionTaskMetricsResourceFetchTypeNetworkLoad) {
+            networkLoadMetrics = transactionMetrics;
+            break;
+        }
+    }
+    NSString *connectionIdentifier = JBHTTPSessionManagerConnectionIdentifier(networkLoadMetrics);
+    
+    // 预热请求只记下用过的连接, 自己不算, 也不回调
+    if (JBHTTPSessionManagerIsPreconnectTask(task)) {
+        if (connectionIdentifier) {
+            [self.preconnectLock lock];
+            [self.preconnectedConnectionIdentifiers addObject:connectionIdentifier];
+            [self.preconnectLock unlock];
+        }
+        return;
+    }
+    
+    if (networkLoadMetrics) {
+        self.countOfMeasuredRequests += 1;
+        if (networkLoadMetrics.isReusedConnection) {
+            self.countOfRequestsReusingConnection += 1;
+            
+            [self.preconnectLock lock];
+            BOOL preconnected = connectionIdentifier && [self.preconnectedConnectionIdentifiers containsObject:connectionIdentifier];
+            [self.preconnectLock unlock];
+            
+            if (preconnected) {
+                self.countOfRequestsReusingPreconnectedConnection += 1;
+            }
+        }
+    }
+    
+    [super URLSession:session task:task didFinishCollectingMetrics:metrics];
+}
+
+#pragma mark - NSURLSessionDataDelegate
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveResponse:(NSURLResponse *)response completionHandler:(void (^)(NSURLSessionResponseDisposition))completionHandler {
+    if (JBHTTPSessionManagerIsPreconnectTask(dataTask)) {
+        if (completionHandler) {
+            completionHandler(NSURLSessionResponseAllow);
+        }
+        return;
+    }
+    
+    [super URLSession:session dataTask:dataTask didReceiveResponse:response completionHandler:completionHandler];
+}
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveData:(NSData *)data {
+    if (JBHTTPSessionManagerIsPreconnectTask(dataTask)) {
+        return;
+    }
+    
+    [super URLSession:session dataTask:dataTask didReceiveData:data];
+}
+
+- (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask willCacheResponse:(NSCachedURLResponse *)proposedResponse completionHandler:(void (^)(NSCachedURLResponse * _Nullable))completionHandler {
+    // 预热请求的响应不缓存
+    if (JBHTTPSessionManagerIsPreconnectTask(dataTask)) {
+        if (completionHandler) {
+            completionHandler(nil);
+        }
+        return;
+    }
+    
+    [super URLSession:session dataTask:dataTask willCacheResponse:proposedResponse completionHandler:completionHandler];
+}
+
+
 #pragma mark - NSObject
 
 - (NSString *)description {
@@ -252,6 +560,7 @@
     HTTPClient.requestSerializer = [self.requestSerializer copyWithZone:zone];
     HTTPClient.responseSerializer = [self.responseSerializer copyWithZone:zone];
     HTTPClient.securityPolicy = [self.securityPolicy copyWithZone:zone];
+    HTTPClient.preconnectKeepAliveInterval = self.preconnectKeepAliveInterval;
     return HTTPClient;
 }
 @end
@@ -9,6 +9,8 @@
 #import <Foundation/Foundation.h>
 #import <CoreGraphics/CoreGraphics.h>
 
+#import "JBXMLDocument.h"
+
 
 /// 可以对有效的数据进行验证,或者对传入的响应数据进行验证
 @protocol JBURLResponseSerialization <NSObject, NSSecureCoding, NSCopying>
@@ -73,9 +75,69 @@
 
 @end
 
+/// 模型类可以实现的方法, 用来调整JSON到属性的映射
+@protocol JBModelDecoding <NSObject>
+
+@optional
+
+/// 属性名 -> JSON里的key, 没有列出来的属性直接用属性名
++ (NSDictionary <NSString *, NSString *> *)jb_JSONKeysByPropertyName;
+
+/// 属性名 -> 数组属性里元素的模型类
++ (NSDictionary <NSString *, Class> *)jb_modelClassesByPropertyName;
+
+@end
+
+/**
+ 直接把JSON解码成模型对象, 顶层是数组的时候返回模型数组
+
+ 每个模型类只用runtime读一次属性列表, 缓存JSON key到setter<没有setter的只读属性用ivar>的映射
+ null值在赋值的时候直接跳过, 不需要先复制一遍字典去掉null, 中间的字典树解码完马上释放
+ 属性是模型类并且值是字典的时候递归解码, 数组属性的元素类型通过`+jb_modelClassesByPropertyName`指定
+ */
+@interface JBModelResponseSerializer : JBJSONResponseSerializer
+
+/// 模型类, nil的时候和JBJSONResponseSerializer一样返回JSON对象
+@property (nonatomic, strong) Class modelClass;
+
+/// 模型数据所在的key路径, 比如 `data.items`, 默认nil表示顶层
+@property (nonatomic, copy) NSString *rootKeyPath;
+
+/// 根据模型类创建
++ (instancetype)serializerWithModelClass:(Class)modelClass;
+
+@end
+
+/**
+ XML响应的序列化方式
+
+ - JBXMLParserResponseSerializationModeParser: 返回还没有开始解析的NSXMLParser对象<默认>, 解析会落到完成回调所在的线程
+ - JBXMLParserResponseSerializationModeDocument: 在序列化队列上解析成紧凑的JBXMLDocument节点树
+ - JBXMLParserResponseSerializationModeExtraction: 在序列化队列上流式提取extractionPaths里的字段, 不建立节点树
+ */
+typedef NS_ENUM(NSUInteger, JBXMLParserResponseSerializationMode) {
+    JBXMLParserResponseSerializationModeParser     = 0,
+    JBXMLParserResponseSerializationModeDocument   = 1,
+    JBXMLParserResponseSerializationModeExtraction = 2
+};
+
 /// 将XML响应序列化成为NSXMLParser对象 默认接受:  - `application/xml`  - `text/xml`
 @interface JBXMLParserResponseSerializer : JBHTTPResponseSerializer
 
+- (instancetype)init;
+
+/// 序列化方式, 默认JBXMLParserResponseSerializationModeParser
+@property (nonatomic, assign) JBXMLParserResponseSerializationMode mode;
+
+/// Extraction模式下要提取的路径, 格式见`+[JBXMLDocument valuesForPaths:inData:error:]`, 返回以路径为key的字典
+@property (nonatomic, copy) NSArray <NSString *> *extractionPaths;
+
+/// 根据序列化方式创建
++ (instancetype)serializerWithMode:(JBXMLParserResponseSerializationMode)mode;
+
+/// 创建Extraction模式的序列化, 只返回指定路径的字段
++ (instancetype)serializerWithExtractionPaths:(NSArray <NSString *> *)extractionPaths;
+
 @end
 
 ///// 将XML响应序列化成为NSXMLDocument对象 默认接受:  - `application/xml`  - `text/xml`
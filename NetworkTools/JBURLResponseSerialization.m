@@ -10,6 +10,7 @@
 
 #import <TargetConditionals.h>
 #import <UIKit/UIKit.h>
+#import <objc/runtime.h>
 
 NSString * const JBURLResponseSerializationErrorDomain = @"JBURLResponseSerializationErrorDomain";
 
@@ -268,6 +269,461 @@ static id JBJSONObjectByRemovingKeysWithNullValues(id JSONObject, NSJSONReadingO
 
 @end
 
+#pragma mark - 模型解码
+
+/// 模型的一个属性, 保存JSON key和赋值的方式
+@interface JBModelPropertyMetadata : NSObject
+@property (nonatomic, copy) NSString *JSONKey;
+/// 类型编码的第一个字符, '@'表示对象
+@property (nonatomic, assign) char encoding;
+/// 对象属性的类, id类型是Nil
+@property (nonatomic, assign) Class propertyClass;
+/// 属性声明里的协议, 例如 id<Foo> 和 NSString<NSCopying>
+@property (nonatomic, copy) NSArray <Protocol *> *protocols;
+/// 属性的类是模型类, 字典可以递归解码
+@property (nonatomic, assign, getter = isModelProperty) BOOL modelProperty;
+/// 可变容器属性对应的不可变类型, JSON里的值要mutableCopy一份
+@property (nonatomic, assign) Class mutableCopySourceClass;
+/// 数组属性里元素的模型类
+@property (nonatomic, assign) Class elementClass;
+@property (nonatomic, assign) SEL setter;
+@property (nonatomic, assign) IMP setterIMP;
+/// 没有setter的只读属性直接写ivar
+@property (nonatomic, assign) Ivar ivar;
+@property (nonatomic, assign) ptrdiff_t ivarOffset;
+@end
+
+/// 一个模型类所有可以赋值的属性, 每个类只创建一次
+@interface JBModelClassMetadata : NSObject
+@property (nonatomic, copy) NSArray <JBModelPropertyMetadata *> *properties;
++ (instancetype)metadataForClass:(Class)modelClass;
+@end
+
+static id JBModelObjectFromJSONObject(id JSONObject, Class modelClass);
+
+/// 只有模型类才能用字典递归解码: 遵守JBModelDecoding, 或者不是系统框架里的类
+/// 系统的类alloc init出来的是空值<NSDate是当前时间, NSString是空字符串>, 不能当成解码结果
+static BOOL JBModelClassIsDecodable(Class cls) {
+    if ([cls conformsToProtocol:@protocol(JBModelDecoding)]) {
+        return YES;
+    }
+    
+    // 按类所在的镜像判断, 模拟器上系统框架的路径前面还有一段运行时的目录
+    const char *imageName = class_getImageName(cls);
+    if (!imageName) {
+        return NO;
+    }
+    return !strstr(imageName, "/System/Library/") && !strstr(imageName, "/usr/lib/");
+}
+
+@implementation JBModelPropertyMetadata
+
+- (instancetype)initWithProperty:(objc_property_t)property ofClass:(Class)modelClass JSONKeys:(NSDictionary *)JSONKeys elementClasses:(NSDictionary *)elementClasses {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    NSString *name = @(property_getName(property));
+    
+    char *type = property_copyAttributeValue(property, "T");
+    if (!type) {
+        return nil;
+    }
+    self.encoding = type[0];
+    
+    // 对象的类型编码是 @"NSString" @"NSString<NSCopying>" @"<Foo>" 这种形式, 块是 @?, id 是 @
+    NSString *className = nil;
+    NSString *protocolNames = nil;
+    BOOL isBlock = self.encoding == '@' && type[1] == '?';
+    if (self.encoding == '@' && type[1] == '"' && strlen(type) > 3) {
+        NSString *typeName = [[NSString alloc] initWithBytes:type + 2 length:strlen(type) - 3 encoding:NSUTF8StringEncoding];
+        NSRange protocolRange = [typeName rangeOfString:@"<"];
+        if (protocolRange.location == NSNotFound) {
+            className = typeName;
+        } else {
+            className = [typeName substringToIndex:protocolRange.location];
+            protocolNames = [typeName substringFromIndex:protocolRange.location];
+        }
+    }
+    free(type);
+    
+    if (isBlock || !strchr("@cCsSiIlLqQfdB", self.encoding)) {
+        return nil;
+    }
+    
+    if (className.length > 0) {
+        self.propertyClass = NSClassFromString(className);
+        // 类没有链接进来, 没法检查类型, 不赋值
+        if (!self.propertyClass) {
+            return nil;
+        }
+    }
+    
+    NSMutableArray *protocols = [NSMutableArray array];
+    for (NSString *protocolName in [protocolNames componentsSeparatedByCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@"<>"]]) {
+        Protocol *protocol = protocolName.length > 0 ? NSProtocolFromString(protocolName) : nil;
+        if (protocol) {
+            [protocols addObject:protocol];
+        }
+    }
+    self.protocols = protocols;
+    
+    Class propertyClass = self.propertyClass;
+    if (propertyClass) {
+        self.modelProperty = JBModelClassIsDecodable(propertyClass);
+        
+        if ([propertyClass isSubclassOfClass:[NSMutableArray class]]) {
+            self.mutableCopySourceClass = [NSArray class];
+        } else if ([propertyClass isSubclassOfClass:[NSMutableDictionary class]]) {
+            self.mutableCopySourceClass = [NSDictionary class];
+        } else if ([propertyClass isSubclassOfClass:[NSMutableString class]]) {
+            self.mutableCopySourceClass = [NSString class];
+        }
+    }
+    
+    char *readonly = property_copyAttributeValue(property, "R");
+    if (readonly) {
+        free(readonly);
+        
+        char *ivarName = property_copyAttributeValue(property, "V");
+        if (!ivarName) {
+            return nil;
+        }
+        self.ivar = class_getInstanceVariable(modelClass, ivarName);
+        free(ivarName);
+        
+        if (!self.ivar) {
+            return nil;
+        }
+        self.ivarOffset = ivar_getOffset(self.ivar);
+    } else {
+        char *setterName = property_copyAttributeValue(property, "S");
+        if (setterName) {
+            self.setter = sel_registerName(setterName);
+            free(setterName);
+        } else {
+            self.setter = NSSelectorFromString([NSString stringWithFormat:@"set%@%@:", [name substringToIndex:1].uppercaseString, [name substringFromIndex:1]]);
+        }
+        
+        if (![modelClass instancesRespondToSelector:self.setter]) {
+            return nil;
+        }
+        self.setterIMP = [modelClass instanceMethodForSelector:self.setter];
+    }
+    
+    self.JSONKey = JSONKeys[name] ?: name;
+    self.elementClass = elementClasses[name];
+    
+    return self;
+}
+
+/// 把JSON值转换成属性需要的对象, 还要遵守属性声明的协议, 转换不了返回nil
+- (id)objectFromJSONValue:(id)value {
+    id object = [self objectOfPropertyClassFromJSONValue:value];
+    
+    for (Protocol *protocol in self.protocols) {
+        if (![object conformsToProtocol:protocol]) {
+            return nil;
+        }
+    }
+    
+    return object;
+}
+
+- (id)objectOfPropertyClassFromJSONValue:(id)value {
+    Class propertyClass = self.propertyClass;
+    if (!propertyClass) {
+        return value;
+    }
+    
+    if (self.elementClass && [value isKindOfClass:[NSArray class]]) {
+        value = JBModelObjectFromJSONObject(value, self.elementClass);
+    }
+    
+    // JSON里的容器和字符串都是不可变的<NSCFString还能通过NSMutableString的类型检查>, 可变属性拷贝一份
+    if (self.mutableCopySourceClass) {
+        if ([value isKindOfClass:[NSNumber class]] && self.mutableCopySourceClass == [NSString class]) {
+            value = [value stringValue];
+        }
+        id object = [value isKindOfClass:self.mutableCopySourceClass] ? [value mutableCopy] : nil;
+        return [object isKindOfClass:propertyClass] ? object : nil;
+    }
+    
+    if ([value isKindOfClass:propertyClass]) {
+        return value;
+    }
+    
+    if ([value isKindOfClass:[NSDictionary class]] && self.isModelProperty) {
+        return JBModelObjectFromJSONObject(value, propertyClass);
+    }
+    
+    if ([value isKindOfClass:[NSNumber class]]) {
+        if ([propertyClass isSubclassOfClass:[NSString class]]) {
+            return [value stringValue];
+        } else if ([propertyClass isSubclassOfClass:[NSDate class]]) {
+            return [NSDate dateWithTimeIntervalSince1970:[value doubleValue]];
+        }
+    } else if ([value isKindOfClass:[NSString class]]) {
+        if ([propertyClass isSubclassOfClass:[NSNumber class]]) {
+            NSDecimalNumber *number = [NSDecimalNumber decimalNumberWithString:value];
+            return [number isEqualToNumber:[NSDecimalNumber notANumber]] ? nil : number;
+        } else if ([propertyClass isSubclassOfClass:[NSURL class]]) {
+            return [NSURL URLWithString:value];
+        }
+    }
+    
+    return nil;
+}
+
+/// 通过setter或者ivar偏移写入标量
+#define JBModelSetScalarValue(scalarType, scalarValue) \
+    do { \
+        scalarType scalar = (scalarValue); \
+        if (self.setter) { \
+            ((void (*)(id, SEL, scalarType))self.setterIMP)(model, self.setter, scalar); \
+        } else { \
+            *(scalarType *)((uint8_t *)(__bridge void *)model + self.ivarOffset) = scalar; \
+        } \
+    } while (0)
+
+- (void)setJSONValue:(id)value forModel:(id)model {
+    if (self.encoding == '@') {
+        id object = [self objectFromJSONValue:value];
+        if (!object) {
+            return;
+        }
+        
+        if (self.setter) {
+            ((void (*)(id, SEL, id))self.setterIMP)(model, self.setter, object);
+        } else {
+            object_setIvar(model, self.ivar, object);
+        }
+        return;
+    }
+    
+    NSNumber *number = nil;
+    if ([value isKindOfClass:[NSNumber class]]) {
+        number = value;
+    } else if ([value isKindOfClass:[NSString class]]) {
+        number = [NSDecimalNumber decimalNumberWithString:value];
+        if ([number isEqualToNumber:[NSDecimalNumber notANumber]]) {
+            return;
+        }
+    } else {
+        return;
+    }
+    
+    switch (self.encoding) {
+        case 'c': JBModelSetScalarValue(char, number.charValue); break;
+        case 'C': JBModelSetScalarValue(unsigned char, number.unsignedCharValue); break;
+        case 's': JBModelSetScalarValue(short, number.shortValue); break;
+        case 'S': JBModelSetScalarValue(unsigned short, number.unsignedShortValue); break;
+        case 'i': JBModelSetScalarValue(int, number.intValue); break;
+        case 'I': JBModelSetScalarValue(unsigned int, number.unsignedIntValue); break;
+        case 'l': JBModelSetScalarValue(long, number.longValue); break;
+        case 'L': JBModelSetScalarValue(unsigned long, number.unsignedLongValue); break;
+        case 'q': JBModelSetScalarValue(long long, number.longLongValue); break;
+        case 'Q': JBModelSetScalarValue(unsigned long long, number.unsignedLongLongValue); break;
+        case 'f': JBModelSetScalarValue(float, number.floatValue); break;
+        case 'd': JBModelSetScalarValue(double, number.doubleValue); break;
+        case 'B': JBModelSetScalarValue(bool, number.boolValue); break;
+        default: break;
+    }
+}
+
+#undef JBModelSetScalarValue
+
+@end
+
+@implementation JBModelClassMetadata
+
++ (instancetype)metadataForClass:(Class)modelClass {
+    static NSMutableDictionary *metadataByClass = nil;
+    static NSLock *metadataLock = nil;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        metadataByClass = [NSMutableDictionary dictionary];
+        metadataLock = [[NSLock alloc] init];
+    });
+    
+    id <NSCopying> key = (id <NSCopying>)modelClass;
+    
+    [metadataLock lock];
+    JBModelClassMetadata *metadata = metadataByClass[key];
+    [metadataLock unlock];
+    
+    if (metadata) {
+        return metadata;
+    }
+    
+    // 在锁外面读runtime, 并发的时候最多重复创建一次, 以先存进去的为准
+    metadata = [[self alloc] initWithClass:modelClass];
+    
+    [metadataLock lock];
+    if (metadataByClass[key]) {
+        metadata = metadataByClass[key];
+    } else {
+        metadataByClass[key] = metadata;
+    }
+    [metadataLock unlock];
+    
+    return metadata;
+}
+
+- (instancetype)initWithClass:(Class)modelClass {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    NSDictionary *JSONKeys = [modelClass respondsToSelector:@selector(jb_JSONKeysByPropertyName)] ? [(Class<JBModelDecoding>)modelClass jb_JSONKeysByPropertyName] : nil;
+    NSDictionary *elementClasses = [modelClass respondsToSelector:@selector(jb_modelClassesByPropertyName)] ? [(Class<JBModelDecoding>)modelClass jb_modelClassesByPropertyName] : nil;
+    
+    NSMutableArray *properties = [NSMutableArray array];
+    NSMutableSet *propertyNames = [NSMutableSet set];
+    
+    // 从子类往父类找, 子类重新声明的属性优先
+    for (Class currentClass = modelClass; currentClass && currentClass != [NSObject class]; currentClass = class_getSuperclass(currentClass)) {
+        unsigned int count = 0;
+        objc_property_t *propertyList = class_copyPropertyList(currentClass, &count);
+        for (unsigned int i = 0; i < count; i++) {
+            NSString *name = @(property_getName(propertyList[i]));
+            if ([propertyNames containsObject:name]) {
+                continue;
+            }
+            [propertyNames addObject:name];
+            
+            JBModelPropertyMetadata *property = [[JBModelPropertyMetadata alloc] initWithProperty:propertyList[i] ofClass:modelClass JSONKeys:JSONKeys elementClasses:elementClasses];
+            if (property) {
+                [properties addObject:property];
+            }
+        }
+        free(propertyList);
+    }
+    
+    self.properties = properties;
+    
+    return self;
+}
+
+@end
+
+/// 字典解码成模型, 数组解码成模型数组
+static id JBModelObjectFromJSONObject(id JSONObject, Class modelClass) {
+    if ([JSONObject isKindOfClass:[NSArray class]]) {
+        NSMutableArray *models = [NSMutableArray arrayWithCapacity:[JSONObject count]];
+        for (id element in JSONObject) {
+            @autoreleasepool {
+                id model = JBModelObjectFromJSONObject(element, modelClass);
+                if (model) {
+                    [models addObject:model];
+                }
+            }
+        }
+        return models;
+    }
+    
+    if (![JSONObject isKindOfClass:[NSDictionary class]]) {
+        return nil;
+    }
+    
+    JBModelClassMetadata *metadata = [JBModelClassMetadata metadataForClass:modelClass];
+    id model = [[modelClass alloc] init];
+    
+    // 按属性查字典, 模型用不到的key不会碰
+    for (JBModelPropertyMetadata *property in metadata.properties) {
+        id value = JSONObject[property.JSONKey];
+        if (!value || value == (id)kCFNull) {
+            continue;
+        }
+        
+        [property setJSONValue:value forModel:model];
+    }
+    
+    return model;
+}
+
+@implementation JBModelResponseSerializer
+
++ (instancetype)serializerWithModelClass:(Class)modelClass {
+    JBModelResponseSerializer *serializer = [self serializer];
+    serializer.modelClass = modelClass;
+    
+    return serializer;
+}
+
+#pragma mark - JBURLResponseSerialization
+- (id)responseObjectForResponse:(NSURLResponse *)response data:(NSData *)data error:(NSError *__autoreleasing *)error {
+    if (![self validateResponse:(NSHTTPURLResponse *)response data:data error:error]) {
+        if (!error || JBErrorOrUnderlyingErrorHasCodeInDomain(*error, NSURLErrorCannotDecodeContentData, JBURLResponseSerializationErrorDomain)) {
+            return nil;
+        }
+    }
+    
+    BOOL isSpace = [data isEqualToData:[NSData dataWithBytes:" " length:1]];
+    if (data.length == 0 || isSpace) {
+        return nil;
+    }
+    
+    id responseObject = nil;
+    NSError *serializationError = nil;
+    
+    // 中间的字典树只活在这个自动释放池里, 映射完就释放
+    @autoreleasepool {
+        id JSONObject = [NSJSONSerialization JSONObjectWithData:data options:self.readingOptions error:&serializationError];
+        
+        if (self.rootKeyPath && [JSONObject isKindOfClass:[NSDictionary class]]) {
+            JSONObject = [JSONObject valueForKeyPath:self.rootKeyPath];
+        }
+        
+        if (self.modelClass) {
+            responseObject = JBModelObjectFromJSONObject(JSONObject, self.modelClass);
+        } else if (self.removesKeysWithNullValues && JSONObject) {
+            responseObject = JBJSONObjectByRemovingKeysWithNullValues(JSONObject, self.readingOptions);
+        } else {
+            responseObject = JSONObject;
+        }
+    }
+    
+    if (error) {
+        *error = JBErrorWithUnderlyingError(serializationError, *error);
+    }
+    
+    return responseObject;
+}
+
+#pragma mark - NSSecureCoding
+- (instancetype)initWithCoder:(NSCoder *)decoder {
+    self = [super initWithCoder:decoder];
+    if (!self) {
+        return nil;
+    }
+    
+    NSString *className = [decoder decodeObjectOfClass:[NSString class] forKey:NSStringFromSelector(@selector(modelClass))];
+    self.modelClass = className ? NSClassFromString(className) : Nil;
+    self.rootKeyPath = [decoder decodeObjectOfClass:[NSString class] forKey:NSStringFromSelector(@selector(rootKeyPath))];
+    
+    return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)coder {
+    [super encodeWithCoder:coder];
+    
+    [coder encodeObject:self.modelClass ? NSStringFromClass(self.modelClass) : nil forKey:NSStringFromSelector(@selector(modelClass))];
+    [coder encodeObject:self.rootKeyPath forKey:NSStringFromSelector(@selector(rootKeyPath))];
+}
+
+- (instancetype)copyWithZone:(NSZone *)zone {
+    JBModelResponseSerializer *serializer = [super copyWithZone:zone];
+    serializer.modelClass = self.modelClass;
+    serializer.rootKeyPath = self.rootKeyPath;
+    
+    return serializer;
+}
+
+@end
+
 #pragma mark JBXMLParserResponseSerializer
 @implementation JBXMLParserResponseSerializer 
 
@@ -277,6 +733,20 @@ static id JBJSONObjectByRemovingKeysWithNullValues(id JSONObject, NSJSONReadingO
     return serializer;
 }
 
++ (instancetype)serializerWithMode:(JBXMLParserResponseSerializationMode)mode {
+    JBXMLParserResponseSerializer *serializer = [[self alloc] init];
+    serializer.mode = mode;
+    
+    return serializer;
+}
+
++ (instancetype)serializerWithExtractionPaths:(NSArray<NSString *> *)extractionPaths {
+    JBXMLParserResponseSerializer *serializer = [self serializerWithMode:JBXMLParserResponseSerializationModeExtraction];
+    serializer.extractionPaths = extractionPaths;
+    
+    return serializer;
+}
+
 - (instancetype)init {
     self = [super init];
     if (!self) {
@@ -297,7 +767,57 @@ static id JBJSONObjectByRemovingKeysWithNullValues(id JSONObject, NSJSONReadingO
         }
     }
     
-    return [[NSXMLParser alloc] initWithData:data];
+    if (self.mode == JBXMLParserResponseSerializationModeParser) {
+        return [[NSXMLParser alloc] initWithData:data];
+    }
+    
+    if (data.length == 0) {
+        return nil;
+    }
+    
+    // 3. 直接在序列化队列上解析, 完成回调拿到的是解析好的结果
+    id responseObject = nil;
+    NSError *serializationError = nil;
+    
+    if (self.mode == JBXMLParserResponseSerializationModeExtraction) {
+        responseObject = [JBXMLDocument valuesForPaths:self.extractionPaths ?: @[] inData:data error:&serializationError];
+    } else {
+        responseObject = [JBXMLDocument documentWithData:data error:&serializationError];
+    }
+    
+    if (error) {
+        *error = JBErrorWithUnderlyingError(serializationError, *error);
+    }
+    
+    return responseObject;
+}
+
+#pragma mark - NSSecureCoding
+- (instancetype)initWithCoder:(NSCoder *)decoder {
+    self = [super initWithCoder:decoder];
+    if (!self) {
+        return nil;
+    }
+    
+    self.mode = [[decoder decodeObjectOfClass:[NSNumber class] forKey:NSStringFromSelector(@selector(mode))] unsignedIntegerValue];
+    self.extractionPaths = [decoder decodeObjectOfClasses:[NSSet setWithObjects:[NSArray class], [NSString class], nil] forKey:NSStringFromSelector(@selector(extractionPaths))];
+    
+    return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)coder {
+    [super encodeWithCoder:coder];
+    
+    [coder encodeObject:@(self.mode) forKey:NSStringFromSelector(@selector(mode))];
+    [coder encodeObject:self.extractionPaths forKey:NSStringFromSelector(@selector(extractionPaths))];
+}
+
+- (instancetype)copyWithZone:(NSZone *)zone {
+    JBXMLParserResponseSerializer *serializer = [super copyWithZone:zone];
+    serializer.mode = self.mode;
+    serializer.extractionPaths = self.extractionPaths;
+    
+    return serializer;
 }
 
 @end
@@ -13,6 +13,13 @@
 #import "JBSecurityPolicy.h"
 #import "JBNetworkReachabilityManager.h"
 
+/// 流式写入文件的时候顺便计算的摘要
+typedef NS_OPTIONS(NSUInteger, JBURLSessionStreamingDigestOptions) {
+    JBURLSessionStreamingDigestNone   = 0,
+    JBURLSessionStreamingDigestSHA256 = 1 << 0,
+    JBURLSessionStreamingDigestCRC32  = 1 << 1
+};
+
 @interface JBURLSessionManager : NSObject <NSURLSessionDelegate, NSURLSessionTaskDelegate, NSURLSessionDataDelegate, NSURLSessionDownloadDelegate, NSSecureCoding, NSCopying>
 
 @property (readonly, nonatomic, strong) NSURLSession *session;
@@ -39,6 +46,10 @@
 
 @property (nonatomic, assign) BOOL attemptsToRecreateUploadTasksForBackgroundSessions;
 
+/// 流式写入文件的时候最多缓冲多少字节还没写到磁盘的数据, 超过以后暂停这个任务, 写到一半以下再恢复, 默认4MB
+/// 这种暂停和调用者的suspend/resume分开记录, 也不发暂停恢复的通知
+@property (nonatomic, assign) NSUInteger maximumStreamingBufferSize;
+
 - (instancetype)initWithSessionConfiguration:(NSURLSessionConfiguration *)configuration NS_DESIGNATED_INITIALIZER;
 
 - (void)invalidateSessionCancleTask:(BOOL)cancelPendingTasks;
@@ -52,6 +63,29 @@
                              downloadProgress:(void(^)(NSProgress *downloadProgress))downloadProgressBlock
                             completionHandler:(void (^)(NSURLResponse *response, id responseObject, NSError *error))completionHandler;
 
+/**
+ 响应体不放在内存里, 收到一块就在后台队列写一块到文件, 同时计算摘要, 完成以后不用再读一遍文件校验
+
+ @param request 请求
+ @param fileURL 写入的文件, 先写同目录下的临时文件, 成功以后才替换已经存在的文件, 失败的时候删掉临时文件
+ @param digestOptions 需要计算的摘要
+ @param downloadProgressBlock 下载进度
+ @param completionHandler 所有数据写完以后回调, digests的key是JBURLSessionStreamingDigestSHA256Key/JBURLSessionStreamingDigestCRC32Key, 不经过responseSerializer, 状态码不在responseSerializer的acceptableStatusCodes里的时候返回错误; 写入失败会取消任务并返回写入的错误
+ @return 数据任务, 文件打不开的时候返回nil, 错误在completionQueue上回调
+ */
+- (NSURLSessionDataTask *)dataTaskWithRequest:(NSURLRequest *)request
+                              streamingToFile:(NSURL *)fileURL
+                                digestOptions:(JBURLSessionStreamingDigestOptions)digestOptions
+                             downloadProgress:(void(^)(NSProgress *downloadProgress))downloadProgressBlock
+                            completionHandler:(void (^)(NSURLResponse *response, NSDictionary <NSString *, id> *digests, NSError *error))completionHandler;
+
+/// 写入调用者打开的文件描述符, 从当前位置开始写, 完成以后不会关闭<描述符无效的时候返回nil>
+- (NSURLSessionDataTask *)dataTaskWithRequest:(NSURLRequest *)request
+                    streamingToFileDescriptor:(int)fileDescriptor
+                                digestOptions:(JBURLSessionStreamingDigestOptions)digestOptions
+                             downloadProgress:(void(^)(NSProgress *downloadProgress))downloadProgressBlock
+                            completionHandler:(void (^)(NSURLResponse *response, NSDictionary <NSString *, id> *digests, NSError *error))completionHandler;
+
 - (NSURLSessionUploadTask *)uploadTaskWithRequest:(NSURLRequest *)request
                                          fromFile:(NSURL *)fileURL
                                          progress:(void (^)(NSProgress *uploadProgress))uploadProgressBlock
@@ -99,6 +133,8 @@
 
 - (void)setTaskDidCompletionBlock:(void (^)(NSURLSession *session, NSURLSessionTask *task, NSError *error))block;
 
+- (void)setTaskDidFinishCollectingMetricsBlock:(void (^)(NSURLSession *session, NSURLSessionTask *task, NSURLSessionTaskMetrics *metrics))block NS_AVAILABLE_IOS(10_0);
+
 - (void)setDataTaskDidReceiveResponseBlock:(NSURLSessionResponseDisposition (^)(NSURLSession *session, NSURLSessionTask *dataTask, NSURLResponse *response))block;
 
 - (void)setDataTaskDidBecomeDownloadTaskBlock:(void (^)(NSURLSession *session, NSURLSessionDataTask *dataTask, NSURLSessionDownloadTask *downloadTask))block;
@@ -138,3 +174,9 @@ FOUNDATION_EXPORT NSString * const JBNetworkingTaskDidCompleteAssetPathKey;
 
 FOUNDATION_EXPORT NSString * const JBNetworkingTaskDidCompleteErrorKey;
 
+/// SHA-256摘要, 32个字节的NSData
+FOUNDATION_EXPORT NSString * const JBURLSessionStreamingDigestSHA256Key;
+
+/// CRC32校验和, NSNumber
+FOUNDATION_EXPORT NSString * const JBURLSessionStreamingDigestCRC32Key;
+
@@ -8,6 +8,10 @@
 
 #import "JBURLSessionManager.h"
 #import <objc/runtime.h>
+#import <CommonCrypto/CommonDigest.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import <zlib.h>
 
 #ifndef NSFoundationVersionNumber_iOS_8_0
 #define NSFoundationVersionNumber_With_Fixed_5871104061079552_bug 1140.11
@@ -54,6 +58,26 @@ static dispatch_group_t url_session_manager_completion_group() {
     return jb_url_session_manager_completion_group;
 }
 
+/// 流式写入的响应体已经在文件里, 不经过responseSerializer, 只按acceptableStatusCodes检查状态码
+static NSError * url_session_manager_streaming_validation_error(id <JBURLResponseSerialization> serializer, NSURLResponse *response) {
+    if (![serializer isKindOfClass:[JBHTTPResponseSerializer class]] || ![response isKindOfClass:[NSHTTPURLResponse class]]) {
+        return nil;
+    }
+    
+    NSHTTPURLResponse *HTTPResponse = (NSHTTPURLResponse *)response;
+    NSIndexSet *acceptableStatusCodes = ((JBHTTPResponseSerializer *)serializer).acceptableStatusCodes;
+    if (!acceptableStatusCodes || [acceptableStatusCodes containsIndex:(NSUInteger)HTTPResponse.statusCode]) {
+        return nil;
+    }
+    
+    NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
+    userInfo[NSLocalizedDescriptionKey] = [NSString stringWithFormat:NSLocalizedStringFromTable(@"%@ (%ld)", @"JBNetworking", nil), [NSHTTPURLResponse localizedStringForStatusCode:HTTPResponse.statusCode], (long)HTTPResponse.statusCode];
+    userInfo[NSURLErrorFailingURLErrorKey] = HTTPResponse.URL;
+    userInfo[JBNetworkingOperationFailingURLResponseErrorKey] = HTTPResponse;
+    
+    return [NSError errorWithDomain:JBURLResponseSerializationErrorDomain code:NSURLErrorBadServerResponse userInfo:userInfo];
+}
+
 NSString * const JBNetworkingTaskDidResumeNotification = @"JBNetworkingTaskDidResumeNotification";
 
 NSString * const JBNetworkingTaskDidCompleteNotification = @"JBNetworkingTaskDidCompleteNotification";
@@ -74,6 +98,10 @@ NSString * const JBNetworkingTaskDidCompleteAssetPathKey = @"JBNetworkingTaskDid
 
 NSString * const JBNetworkingTaskDidCompleteErrorKey = @"JBNetworkingTaskDidCompleteErrorKey";
 
+NSString * const JBURLSessionStreamingDigestSHA256Key = @"JBURLSessionStreamingDigestSHA256Key";
+
+NSString * const JBURLSessionStreamingDigestCRC32Key = @"JBURLSessionStreamingDigestCRC32Key";
+
 
 static NSString * const JBURLSessionManagerLockName = @"JBURLSessionManagerLockName";
 
@@ -91,6 +119,7 @@ typedef void (^JBRULSessionDidFinishEventForBackgroundURLSessionBlock)(NSURLSess
 typedef NSInputStream * (^JBURLSessionTaskNeedNewBodyStreamBlock)(NSURLSession *session, NSURLSessionTask *task);
 typedef void (^JBURLSessionTaskDidSendBodyDataBlock)(NSURLSession *session, NSURLSessionTask *task, int64_t bytesSent, int64_t totalBytesSent, int64_t totalBytesExpectedToSend);
 typedef void (^JBURLSessionTaskDidCompleteBlock)(NSURLSession *session, NSURLSessionTask *task, NSError *error);
+typedef void (^JBURLSessionTaskDidFinishCollectingMetricsBlock)(NSURLSession *session, NSURLSessionTask *task, NSURLSessionTaskMetrics *metrics);
 
 typedef NSURLSessionResponseDisposition (^JBURLSessionDataTaskDidReceiveResponseBlock)(NSURLSession *session, NSURLSessionDataTask *dataTask, NSURLResponse *response);
 typedef void (^JBURLSessionDataTaskDidBecomeDownloadTaskBlock)(NSURLSession *session, NSURLSessionDataTask *dataTask, NSURLSessionDownloadTask *downloadTask);
@@ -105,6 +134,252 @@ typedef void (^JBURLSessionTaskProgressBlock)(NSProgress *);
 typedef void (^JBURLSessionTaskCompletionHandler)(NSURLResponse *response, id responseObject, NSError *error);
 
 
+#pragma mark - JBURLSessionManagerStreamingSink
+
+/// 流式写入的任务关联的sink
+static char JBURLSessionTaskStreamingSinkKey;
+
+/// 交叉以后jb_resume/jb_suspend指向系统原来的实现
+@interface NSURLSessionTask (JBURLSessionTaskSwizzling)
+- (void)jb_resume;
+- (void)jb_suspend;
+@end
+
+/// 把数据块交给后台串行队列写入文件, 写的时候顺便更新摘要
+/// 还没写完的数据超过上限的时候暂停这个任务, 写到一半以下再恢复, 不阻塞代理队列, 不影响其他任务
+/// 调用者的suspend/resume经过交叉方法转到sink, 和缓冲造成的暂停分开记录, 两边都允许的时候任务才真正运行
+@interface JBURLSessionManagerStreamingSink : NSObject {
+    CC_SHA256_CTX _SHA256Context;
+    uLong _CRC32;
+}
+/// 最终的文件, 成功以后才把临时文件换过去
+@property (nonatomic, copy) NSURL *fileURL;
+/// 和fileURL在同一个目录下的临时文件<同一个文件系统, rename是原子的>
+@property (nonatomic, copy) NSURL *temporaryFileURL;
+@property (nonatomic, assign) int fileDescriptor;
+@property (nonatomic, assign) BOOL closesFileDescriptor;
+@property (nonatomic, assign) JBURLSessionStreamingDigestOptions digestOptions;
+@property (nonatomic, assign) NSUInteger maximumBufferSize;
+@property (nonatomic, weak) NSURLSessionDataTask *dataTask;
+/// bufferedSize和暂停状态在代理队列, 写入队列和调用者的线程上都会改, 用锁保护
+/// 父类的resume也被交叉的时候, 子类原来的实现会再回到交叉方法里, 所以用递归锁
+@property (nonatomic, strong) NSRecursiveLock *bufferLock;
+@property (nonatomic, assign) NSUInteger bufferedSize;
+@property (nonatomic, assign, getter = isSuspendedForBackpressure) BOOL suspendedForBackpressure;
+/// 调用者是否暂停了任务, 新建的任务还没有resume, 所以一开始是YES
+@property (nonatomic, assign, getter = isSuspendedByCaller) BOOL suspendedByCaller;
+@property (nonatomic, strong) dispatch_queue_t writeQueue;
+/// 第一次写入失败的错误, 之后的数据直接丢弃, 任务也会被取消<代理队列上也会读, 所以是atomic>
+@property (atomic, strong) NSError *writeError;
+
+/// 调用者调用了任务的suspend/resume
+- (void)setTaskSuspendedByCaller:(BOOL)suspended;
+@end
+
+@implementation JBURLSessionManagerStreamingSink
+
+- (instancetype)initWithFileDescriptor:(int)fileDescriptor digestOptions:(JBURLSessionStreamingDigestOptions)digestOptions maximumBufferSize:(NSUInteger)maximumBufferSize {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    
+    self.fileDescriptor = fileDescriptor;
+    self.digestOptions = digestOptions;
+    self.maximumBufferSize = MAX(maximumBufferSize, 1);
+    self.bufferLock = [[NSRecursiveLock alloc] init];
+    self.suspendedByCaller = YES;
+    self.writeQueue = dispatch_queue_create("jb_url_session_manager_streaming_queue", DISPATCH_QUEUE_SERIAL);
+    
+    CC_SHA256_Init(&_SHA256Context);
+    _CRC32 = crc32(0L, Z_NULL, 0);
+    
+    if (fileDescriptor < 0) {
+        self.writeError = [NSError errorWithDomain:NSPOSIXErrorDomain code:EBADF userInfo:nil];
+    }
+    
+    return self;
+}
+
+- (instancetype)initWithFileURL:(NSURL *)fileURL digestOptions:(JBURLSessionStreamingDigestOptions)digestOptions maximumBufferSize:(NSUInteger)maximumBufferSize {
+    // 先写临时文件, 请求失败的时候已经存在的目标文件不受影响
+    NSString *temporaryFileName = [NSString stringWithFormat:@".%@.%@.download", fileURL.lastPathComponent, [NSUUID UUID].UUIDString];
+    NSURL *temporaryFileURL = [[fileURL URLByDeletingLastPathComponent] URLByAppendingPathComponent:temporaryFileName];
+    
+    int fileDescriptor = open(temporaryFileURL.path.fileSystemRepresentation, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    int openErrno = errno;
+    
+    self = [self initWithFileDescriptor:fileDescriptor digestOptions:digestOptions maximumBufferSize:maximumBufferSize];
+    if (!self) {
+        if (fileDescriptor >= 0) {
+            close(fileDescriptor);
+            unlink(temporaryFileURL.path.fileSystemRepresentation);
+        }
+        return nil;
+    }
+    
+    self.fileURL = fileURL;
+    self.closesFileDescriptor = YES;
+    if (fileDescriptor >= 0) {
+        self.temporaryFileURL = temporaryFileURL;
+    } else {
+        self.writeError = [NSError errorWithDomain:NSPOSIXErrorDomain code:openErrno userInfo:@{NSURLErrorKey: fileURL}];
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    // 任务没有完成就释放了<没有resume或者创建以后被丢掉>, 不留下临时文件
+    if (self.closesFileDescriptor && _fileDescriptor >= 0) {
+        close(_fileDescriptor);
+    }
+    if (_temporaryFileURL) {
+        unlink(_temporaryFileURL.path.fileSystemRepresentation);
+    }
+}
+
+- (void)appendData:(NSData *)data {
+    NSUInteger length = data.length;
+    if (length == 0) {
+        return;
+    }
+    
+    // 已经写不进去了, 不用再下载剩下的数据
+    if (self.writeError) {
+        [self.dataTask cancel];
+        return;
+    }
+    
+    // 缓冲满了就暂停任务, 暂停以后session已经收到的数据可能还会再回调几次, 照样缓冲
+    // 暂停和恢复都在锁里调用, 保证顺序不会颠倒
+    [self.bufferLock lock];
+    self.bufferedSize += length;
+    if (!self.isSuspendedForBackpressure && self.bufferedSize >= self.maximumBufferSize) {
+        self.suspendedForBackpressure = YES;
+        [self updateTaskState];
+    }
+    [self.bufferLock unlock];
+    
+    dispatch_async(self.writeQueue, ^{
+        // 数据可能是不连续的dispatch_data, 按块处理, 不拼成一整块
+        [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
+            [self writeBytes:bytes length:byteRange.length];
+        }];
+        
+        if (self.writeError) {
+            [self.dataTask cancel];
+        }
+        
+        // 写到一半以下再恢复, 避免在上限附近反复暂停恢复
+        [self.bufferLock lock];
+        self.bufferedSize -= length;
+        if (self.isSuspendedForBackpressure && !self.writeError && self.bufferedSize <= self.maximumBufferSize / 2) {
+            self.suspendedForBackpressure = NO;
+            [self updateTaskState];
+        }
+        [self.bufferLock unlock];
+    });
+}
+
+/// 调用者调用了任务的suspend/resume<交叉方法里转过来>
+- (void)setTaskSuspendedByCaller:(BOOL)suspended {
+    [self.bufferLock lock];
+    self.suspendedByCaller = suspended;
+    [self updateTaskState];
+    [self.bufferLock unlock];
+}
+
+/// 调用者和缓冲都允许的时候才运行, 直接调用原来的实现, 不发暂停恢复的通知<调用的时候需要持有bufferLock>
+- (void)updateTaskState {
+    NSURLSessionDataTask *dataTask = self.dataTask;
+    BOOL shouldRun = !self.isSuspendedByCaller && !self.isSuspendedForBackpressure;
+    
+    if (shouldRun) {
+        [dataTask respondsToSelector:@selector(jb_resume)] ? [dataTask jb_resume] : [dataTask resume];
+    } else {
+        [dataTask respondsToSelector:@selector(jb_suspend)] ? [dataTask jb_suspend] : [dataTask suspend];
+    }
+}
+
+/// 在写入队列上调用
+- (void)writeBytes:(const void *)bytes length:(NSUInteger)length {
+    if (self.writeError) {
+        return;
+    }
+    
+    if (self.digestOptions & JBURLSessionStreamingDigestSHA256) {
+        CC_SHA256_Update(&_SHA256Context, bytes, (CC_LONG)length);
+    }
+    if (self.digestOptions & JBURLSessionStreamingDigestCRC32) {
+        _CRC32 = crc32(_CRC32, bytes, (uInt)length);
+    }
+    
+    const uint8_t *remainingBytes = bytes;
+    NSUInteger remaining = length;
+    while (remaining > 0) {
+        ssize_t written = write(self.fileDescriptor, remainingBytes, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            
+            NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
+            userInfo[NSURLErrorKey] = self.fileURL;
+            self.writeError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:userInfo];
+            return;
+        }
+        
+        remainingBytes += written;
+        remaining -= (NSUInteger)written;
+    }
+}
+
+/// 等前面的数据都写完以后回调<在写入队列上>
+/// 写文件的时候, 请求和写入都没有出错才把临时文件换成目标文件, 否则删掉临时文件
+- (void)finishWithRequestError:(NSError *)requestError completionHandler:(void (^)(NSDictionary <NSString *, id> *digests, NSError *error))completionHandler {
+    dispatch_async(self.writeQueue, ^{
+        if (self.closesFileDescriptor && self.fileDescriptor >= 0) {
+            if (close(self.fileDescriptor) != 0 && !self.writeError) {
+                self.writeError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+            }
+            self.fileDescriptor = -1;
+        }
+        
+        NSURL *temporaryFileURL = self.temporaryFileURL;
+        if (temporaryFileURL) {
+            self.temporaryFileURL = nil;
+            
+            if (!requestError && !self.writeError) {
+                if (rename(temporaryFileURL.path.fileSystemRepresentation, self.fileURL.path.fileSystemRepresentation) != 0) {
+                    self.writeError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:@{NSURLErrorKey: self.fileURL}];
+                }
+            }
+            
+            if (requestError || self.writeError) {
+                unlink(temporaryFileURL.path.fileSystemRepresentation);
+            }
+        }
+        
+        NSMutableDictionary *digests = [NSMutableDictionary dictionary];
+        if (!self.writeError) {
+            if (self.digestOptions & JBURLSessionStreamingDigestSHA256) {
+                unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+                CC_SHA256_Final(digest, &self->_SHA256Context);
+                digests[JBURLSessionStreamingDigestSHA256Key] = [NSData dataWithBytes:digest length:sizeof(digest)];
+            }
+            if (self.digestOptions & JBURLSessionStreamingDigestCRC32) {
+                digests[JBURLSessionStreamingDigestCRC32Key] = @((uint32_t)self->_CRC32);
+            }
+        }
+        
+        completionHandler([digests copy], self.writeError);
+    });
+}
+
+@end
+
+
 @interface JBURLSessionManagerTaskDelegate : NSObject <NSURLSessionDataDelegate, NSURLSessionTaskDelegate, NSURLSessionDownloadDelegate>
 
 @property (nonatomic, weak) JBURLSessionManager *manager;
@@ -116,6 +391,8 @@ typedef void (^JBURLSessionTaskCompletionHandler)(NSURLResponse *response, id re
 @property (nonatomic, copy) JBURLSessionTaskProgressBlock uploadProgressBlock;
 @property (nonatomic, copy) JBURLSessionTaskProgressBlock downloadProgressBlock;
 @property (nonatomic, copy) JBURLSessionTaskCompletionHandler completionHandler;
+/// 设置以后响应体不再放进mutableData, 直接写入文件
+@property (nonatomic, strong) JBURLSessionManagerStreamingSink *streamingSink;
 @end
 
 @implementation JBURLSessionManagerTaskDelegate
@@ -224,6 +501,32 @@ typedef void (^JBURLSessionTaskCompletionHandler)(NSURLResponse *response, id re
     __block NSMutableDictionary *userInfo = [NSMutableDictionary dictionary];
     userInfo[JBNetworkingTaskDidCompleteResponseSerializerKey] = manager.responseSerializer;
     
+    if (self.streamingSink) {
+        // 等所有数据写完再回调, 响应体已经在文件里了, 不经过responseSerializer, 但是状态码不对也要报错
+        NSError *requestError = error ?: url_session_manager_streaming_validation_error(manager.responseSerializer, task.response);
+        [self.streamingSink finishWithRequestError:requestError completionHandler:^(NSDictionary<NSString *,id> *digests, NSError *writeError) {
+            // 写入失败的时候任务是被取消的, 优先返回写入的错误
+            NSError *streamingError = writeError ?: requestError;
+            if (streamingError) {
+                userInfo[JBNetworkingTaskDidCompleteErrorKey] = streamingError;
+            } else if (self.streamingSink.fileURL) {
+                userInfo[JBNetworkingTaskDidCompleteAssetPathKey] = self.streamingSink.fileURL;
+            }
+            
+            dispatch_group_async(manager.completionGroup ?: url_session_manager_completion_group(), manager.completionQueue ?: dispatch_get_main_queue(), ^{
+                if (self.completionHandler) {
+                    self.completionHandler(task.response, digests, streamingError);
+                }
+                
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    [[NSNotificationCenter defaultCenter] postNotificationName:JBNetworkingTaskDidCompleteNotification object:task userInfo:userInfo];
+                });
+            });
+        }];
+        
+        return;
+    }
+    
     NSData *data = nil;
     if (self.mutableData) {
         data = self.mutableData.copy;
@@ -240,7 +543,7 @@ typedef void (^JBURLSessionTaskCompletionHandler)(NSURLResponse *response, id re
     if (error) {
         userInfo[JBNetworkingTaskDidCompleteErrorKey] = error;
         
-        dispatch_group_async(manager.completionGroup ?: url_session_manager_completion_group(), manager.completionQueue, ^{
+        dispatch_group_async(manager.completionGroup ?: url_session_manager_completion_group(), manager.completionQueue ?: dispatch_get_main_queue(), ^{
             if (self.completionHandler) {
                 self.completionHandler(task.response, responseObject, error);
             }
@@ -266,7 +569,7 @@ typedef void (^JBURLSessionTaskCompletionHandler)(NSURLResponse *response, id re
                 userInfo[JBNetworkingTaskDidCompleteErrorKey] = serializationError;
             }
             
-            dispatch_group_async(manager.completionGroup ?: url_session_manager_completion_group(), manager.completionQueue, ^{
+            dispatch_group_async(manager.completionGroup ?: url_session_manager_completion_group(), manager.completionQueue ?: dispatch_get_main_queue(), ^{
                 if (self.completionHandler) {
                     self.completionHandler(task.response, responseObject, serializationError);
                 }
@@ -281,7 +584,11 @@ typedef void (^JBURLSessionTaskCompletionHandler)(NSURLResponse *response, id re
 
 #pragma mark - NSURLSessionDataTaskDelegate
 - (void)URLSession:(NSURLSession *)session dataTask:(NSURLSessionDataTask *)dataTask didReceiveData:(NSData *)data {
-    [self.mutableData appendData:data];
+    if (self.streamingSink) {
+        [self.streamingSink appendData:data];
+    } else {
+        [self.mutableData appendData:data];
+    }
 }
 
 
@@ -373,7 +680,14 @@ static NSString * const JBNSURLSessionTaskDidSuspendNotification = @"JBNSURLSess
 - (void)jb_resume {
     NSAssert([self respondsToSelector:@selector(state)], @"无法响应的状态");
     NSURLSessionTaskState state = [self state];
-    [self jb_resume];
+    
+    // 流式写入的任务由sink决定底层是不是真的恢复<缓冲满的时候保持暂停>
+    JBURLSessionManagerStreamingSink *streamingSink = objc_getAssociatedObject(self, &JBURLSessionTaskStreamingSinkKey);
+    if (streamingSink) {
+        [streamingSink setTaskSuspendedByCaller:NO];
+    } else {
+        [self jb_resume];
+    }
     
     if (state != NSURLSessionTaskStateRunning) {
         [[NSNotificationCenter defaultCenter] postNotificationName:JBNSURLSessionTaskDidResumeNotification object:self];
@@ -384,7 +698,13 @@ static NSString * const JBNSURLSessionTaskDidSuspendNotification = @"JBNSURLSess
 - (void)jb_suspend {
     NSAssert([self respondsToSelector:@selector(state)], @"无法响应的状态");
     NSURLSessionTaskState state = [self state];
-    [self jb_suspend];
+    
+    JBURLSessionManagerStreamingSink *streamingSink = objc_getAssociatedObject(self, &JBURLSessionTaskStreamingSinkKey);
+    if (streamingSink) {
+        [streamingSink setTaskSuspendedByCaller:YES];
+    } else {
+        [self jb_suspend];
+    }
     
     if (state != NSURLSessionTaskStateRunning) {
         [[NSNotificationCenter defaultCenter] postNotificationName:JBNSURLSessionTaskDidSuspendNotification object:self];
@@ -410,6 +730,7 @@ static NSString * const JBNSURLSessionTaskDidSuspendNotification = @"JBNSURLSess
 @property (nonatomic, copy) JBURLSessionTaskNeedNewBodyStreamBlock taskNeedNewBodyStream;
 @property (nonatomic, copy) JBURLSessionTaskDidSendBodyDataBlock taskDidSendBodyData;
 @property (nonatomic, copy) JBURLSessionTaskDidCompleteBlock taskDidComplete;
+@property (nonatomic, copy) JBURLSessionTaskDidFinishCollectingMetricsBlock taskDidFinishCollectingMetrics;
 @property (nonatomic, copy) JBURLSessionDataTaskDidReceiveResponseBlock dataTaskDidReceiveResponse;
 @property (nonatomic, copy) JBURLSessionDataTaskDidBecomeDownloadTaskBlock dataTaskDidBecomeDownloadTask;
 @property (nonatomic, copy) JBURLSessionDataTaskDidReceiveDataBlock dataTaskDidReceiveData;
@@ -455,6 +776,8 @@ static NSString * const JBNSURLSessionTaskDidSuspendNotification = @"JBNSURLSess
     self.lock = [[NSLock alloc] init];
     self.lock.name = JBURLSessionManagerLockName;
     
+    self.maximumStreamingBufferSize = 4 * 1024 * 1024;
+    
     [self.session getTasksWithCompletionHandler:^(NSArray<NSURLSessionDataTask *> * _Nonnull dataTasks, NSArray<NSURLSessionUploadTask *> * _Nonnull uploadTasks, NSArray<NSURLSessionDownloadTask *> * _Nonnull downloadTasks) {
         for (NSURLSessionDataTask *task in dataTasks) {
             [self addDelegateForDataTask:task uploadProgress:nil downloadProgress:nil completionHandler:nil];
@@ -685,6 +1008,64 @@ static NSString * const JBNSURLSessionTaskDidSuspendNotification = @"JBNSURLSess
     return dataTask;
 }
 
+- (NSURLSessionDataTask *)dataTaskWithRequest:(NSURLRequest *)request
+                              streamingToFile:(NSURL *)fileURL
+                                digestOptions:(JBURLSessionStreamingDigestOptions)digestOptions
+                             downloadProgress:(void (^)(NSProgress *))downloadProgressBlock
+                            completionHandler:(void (^)(NSURLResponse *, NSDictionary<NSString *,id> *, NSError *))completionHandler {
+    NSParameterAssert([fileURL isFileURL]);
+    
+    JBURLSessionManagerStreamingSink *streamingSink = [[JBURLSessionManagerStreamingSink alloc] initWithFileURL:fileURL digestOptions:digestOptions maximumBufferSize:self.maximumStreamingBufferSize];
+    
+    return [self dataTaskWithRequest:request streamingSink:streamingSink downloadProgress:downloadProgressBlock completionHandler:completionHandler];
+}
+
+- (NSURLSessionDataTask *)dataTaskWithRequest:(NSURLRequest *)request
+                    streamingToFileDescriptor:(int)fileDescriptor
+                                digestOptions:(JBURLSessionStreamingDigestOptions)digestOptions
+                             downloadProgress:(void (^)(NSProgress *))downloadProgressBlock
+                            completionHandler:(void (^)(NSURLResponse *, NSDictionary<NSString *,id> *, NSError *))completionHandler {
+    JBURLSessionManagerStreamingSink *streamingSink = [[JBURLSessionManagerStreamingSink alloc] initWithFileDescriptor:fileDescriptor digestOptions:digestOptions maximumBufferSize:self.maximumStreamingBufferSize];
+    
+    return [self dataTaskWithRequest:request streamingSink:streamingSink downloadProgress:downloadProgressBlock completionHandler:completionHandler];
+}
+
+- (NSURLSessionDataTask *)dataTaskWithRequest:(NSURLRequest *)request
+                                streamingSink:(JBURLSessionManagerStreamingSink *)streamingSink
+                             downloadProgress:(void (^)(NSProgress *))downloadProgressBlock
+                            completionHandler:(void (^)(NSURLResponse *, NSDictionary<NSString *,id> *, NSError *))completionHandler {
+    // 文件打不开就不创建任务, 不白白下载
+    if (streamingSink.writeError) {
+        if (completionHandler) {
+            NSError *writeError = streamingSink.writeError;
+            dispatch_async(self.completionQueue ?: dispatch_get_main_queue(), ^{
+                completionHandler(nil, nil, writeError);
+            });
+        }
+        return nil;
+    }
+    
+    __block NSURLSessionDataTask *dataTask = nil;
+    url_session_manager_create_task_safely(^{
+        dataTask = [self.session dataTaskWithRequest:request];
+    });
+    
+    [self addDelegateForDataTask:dataTask uploadProgress:nil downloadProgress:downloadProgressBlock completionHandler:^(NSURLResponse *response, id responseObject, NSError *error) {
+        if (completionHandler) {
+            completionHandler(response, responseObject, error);
+        }
+    }];
+    
+    // 任务还没有resume, 这时候换成写文件不会漏掉数据
+    streamingSink.dataTask = dataTask;
+    objc_setAssociatedObject(dataTask, &JBURLSessionTaskStreamingSinkKey, streamingSink, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    JBURLSessionManagerTaskDelegate *delegate = [self delegateForTask:dataTask];
+    delegate.streamingSink = streamingSink;
+    delegate.mutableData = nil;
+    
+    return dataTask;
+}
+
 - (NSURLSessionUploadTask *)uploadTaskWithRequest:(NSURLRequest *)request
                                          fromFile:(NSURL *)fileURL
                                          progress:(void (^)(NSProgress *))uploadProgressBlock
@@ -809,6 +1190,10 @@ static NSString * const JBNSURLSessionTaskDidSuspendNotification = @"JBNSURLSess
     self.taskDidComplete = block;
 }
 
+- (void)setTaskDidFinishCollectingMetricsBlock:(void (^)(NSURLSession *, NSURLSessionTask *, NSURLSessionTaskMetrics *))block {
+    self.taskDidFinishCollectingMetrics = block;
+}
+
 #pragma mark -
 
 - (void)setDataTaskDidReceiveResponseBlock:(NSURLSessionResponseDisposition (^)(NSURLSession *, NSURLSessionTask *, NSURLResponse *))block {
@@ -991,6 +1376,14 @@ didCompleteWithError:(NSError *)error {
     }
 }
 
+- (void)URLSession:(NSURLSession *)session
+              task:(NSURLSessionTask *)task
+didFinishCollectingMetrics:(NSURLSessionTaskMetrics *)metrics {
+    if (self.taskDidFinishCollectingMetrics) {
+        self.taskDidFinishCollectingMetrics(session, task, metrics);
+    }
+}
+
 #pragma mark - NRURLSessionDataDelegate
 
 - (void)URLSession:(NSURLSession *)session
@@ -0,0 +1,85 @@
+//
+//  JBXMLDocument.h
+//  JBNetworking
+//
+//  Created by agent on 2026/10/19.
+//  Copyright © 2026年 agent. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class JBXMLDocument;
+
+/// XML元素, 只保存所属的文档和节点下标, 访问属性的时候才从文档里取值
+@interface JBXMLElement : NSObject
+
+/// 所属的文档
+@property (readonly, nonatomic, strong) JBXMLDocument *document;
+
+/// 标签名
+@property (readonly, nonatomic, copy) NSString *name;
+
+/// 元素自己的文本<去掉首尾空白, 不包括子元素的文本>
+@property (readonly, nonatomic, copy) NSString *text;
+
+/// 全部属性
+@property (readonly, nonatomic, copy) NSDictionary <NSString *, NSString *> *attributes;
+
+/// 父元素, 根元素返回nil
+@property (readonly, nonatomic, strong) JBXMLElement *parent;
+
+/// 子元素
+@property (readonly, nonatomic, copy) NSArray <JBXMLElement *> *children;
+
+/// 指定名字的属性值
+- (NSString *)valueForAttribute:(NSString *)name;
+
+/// 第一个指定名字的子元素
+- (JBXMLElement *)firstChildNamed:(NSString *)name;
+
+/// 所有指定名字的子元素
+- (NSArray <JBXMLElement *> *)childrenNamed:(NSString *)name;
+
+@end
+
+
+/**
+ 紧凑的XML节点树
+
+ 所有节点和属性放在连续的内存里, 标签名和属性名只保存一份<字符串池>, 文本放在同一个缓冲区里
+ JBXMLElement只是访问节点的视图, 用到的时候才创建
+ */
+@interface JBXMLDocument : NSObject
+
+/// 根元素
+@property (readonly, nonatomic, strong) JBXMLElement *rootElement;
+
+/// 元素个数
+@property (readonly, nonatomic, assign) NSUInteger elementCount;
+
+/// 解析XML数据, 在调用的线程上同步解析
++ (instancetype)documentWithData:(NSData *)data error:(NSError * __autoreleasing *)error;
+
+/**
+ 流式提取字段, 不建立节点树
+
+ 路径的格式<XPath的子集>:
+ - `/rss/channel/item/title` 以`/`开头表示从根元素开始完整匹配
+ - `item/title` 或者 `//item/title` 表示匹配路径的结尾
+ - `*` 匹配任意标签名
+ - 最后一段是 `@href` 表示取属性的值, 否则取元素的文本<包括子元素的文本>
+ - 不支持中间的 `//`<例如 `rss//title`>, 这样的路径返回JBXMLDocumentErrorDomain的错误
+
+ @param paths 要提取的路径
+ @param data XML数据
+ @param error 路径不支持或者解析的错误
+ @return 以路径为key, 所有匹配的值<按元素开始的文档顺序>为value的字典
+ */
++ (NSDictionary <NSString *, NSArray <NSString *> *> *)valuesForPaths:(NSArray <NSString *> *)paths
+                                                              inData:(NSData *)data
+                                                               error:(NSError * __autoreleasing *)error;
+
+@end
+
+/// 路径不支持的错误域
+FOUNDATION_EXPORT NSString * const JBXMLDocumentErrorDomain;
@@ -0,0 +1,548 @@
+//
+//  JBXMLDocument.m
+//  JBNetworking
+//
+//  Created by agent on 2026/10/19.
+//  Copyright © 2026年 agent. All rights reserved.
+//
+
+#import "JBXMLDocument.h"
+
+NSString * const JBXMLDocumentErrorDomain = @"JBXMLDocumentErrorDomain";
+
+/// 表示没有这个节点
+static uint32_t const JBXMLNodeNotFound = UINT32_MAX;
+
+/// 节点, 全部用下标互相引用, 整棵树放在一块连续的内存里
+typedef struct {
+    uint32_t name;              // 名字在字符串池里的下标
+    uint32_t parent;
+    uint32_t firstChild;
+    uint32_t lastChild;
+    uint32_t nextSibling;
+    uint32_t firstAttribute;    // 属性数组里的起始下标
+    uint32_t attributeCount;
+    uint32_t textLocation;      // 文本在文本缓冲区里的范围
+    uint32_t textLength;
+} JBXMLNode;
+
+/// 属性
+typedef struct {
+    uint32_t name;
+    uint32_t valueLocation;
+    uint32_t valueLength;
+} JBXMLAttribute;
+
+/// 返回字符串在表里唯一的那个实例, 之后可以直接用 == 比较
+static NSString * JBXMLInternedString(NSMutableDictionary <NSString *, NSString *> *internedStrings, NSString *string) {
+    NSString *internedString = internedStrings[string];
+    if (!internedString) {
+        internedString = [string copy];
+        internedStrings[internedString] = internedString;
+    }
+
+    return internedString;
+}
+
+
+@interface JBXMLDocument ()
+@property (nonatomic, strong) NSMutableData *nodes;
+@property (nonatomic, strong) NSMutableData *nodeAttributes;
+@property (nonatomic, strong) NSMutableArray <NSString *> *names;
+@property (nonatomic, strong) NSMutableDictionary <NSString *, NSNumber *> *nameIndexes;
+@property (nonatomic, strong) NSMutableString *textStorage;
+@end
+
+@interface JBXMLElement ()
+@property (readwrite, nonatomic, strong) JBXMLDocument *document;
+@property (nonatomic, assign) uint32_t index;
+- (instancetype)initWithDocument:(JBXMLDocument *)document index:(uint32_t)index;
+@end
+
+
+#pragma mark - JBXMLElement
+
+@implementation JBXMLElement
+
+- (instancetype)initWithDocument:(JBXMLDocument *)document index:(uint32_t)index {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+
+    self.document = document;
+    self.index = index;
+
+    return self;
+}
+
+- (const JBXMLNode *)node {
+    return (const JBXMLNode *)self.document.nodes.bytes + self.index;
+}
+
+- (const JBXMLAttribute *)nodeAttributes {
+    return (const JBXMLAttribute *)self.document.nodeAttributes.bytes + [self node]->firstAttribute;
+}
+
+- (NSString *)name {
+    return self.document.names[[self node]->name];
+}
+
+- (NSString *)text {
+    const JBXMLNode *node = [self node];
+    return [self.document.textStorage substringWithRange:NSMakeRange(node->textLocation, node->textLength)];
+}
+
+- (NSDictionary<NSString *,NSString *> *)attributes {
+    const JBXMLNode *node = [self node];
+    const JBXMLAttribute *attributes = [self nodeAttributes];
+
+    NSMutableDictionary *mutableAttributes = [NSMutableDictionary dictionaryWithCapacity:node->attributeCount];
+    for (uint32_t i = 0; i < node->attributeCount; i++) {
+        mutableAttributes[self.document.names[attributes[i].name]] = [self.document.textStorage substringWithRange:NSMakeRange(attributes[i].valueLocation, attributes[i].valueLength)];
+    }
+
+    return [mutableAttributes copy];
+}
+
+- (NSString *)valueForAttribute:(NSString *)name {
+    NSNumber *nameIndex = self.document.nameIndexes[name];
+    if (!nameIndex) {
+        return nil;
+    }
+
+    const JBXMLNode *node = [self node];
+    const JBXMLAttribute *attributes = [self nodeAttributes];
+    for (uint32_t i = 0; i < node->attributeCount; i++) {
+        if (attributes[i].name == nameIndex.unsignedIntValue) {
+            return [self.document.textStorage substringWithRange:NSMakeRange(attributes[i].valueLocation, attributes[i].valueLength)];
+        }
+    }
+
+    return nil;
+}
+
+- (JBXMLElement *)parent {
+    uint32_t parent = [self node]->parent;
+    return parent == JBXMLNodeNotFound ? nil : [[JBXMLElement alloc] initWithDocument:self.document index:parent];
+}
+
+- (NSArray<JBXMLElement *> *)children {
+    return [self childrenWithNameIndex:JBXMLNodeNotFound limit:NSUIntegerMax];
+}
+
+- (JBXMLElement *)firstChildNamed:(NSString *)name {
+    NSNumber *nameIndex = self.document.nameIndexes[name];
+    return nameIndex ? [self childrenWithNameIndex:nameIndex.unsignedIntValue limit:1].firstObject : nil;
+}
+
+- (NSArray<JBXMLElement *> *)childrenNamed:(NSString *)name {
+    NSNumber *nameIndex = self.document.nameIndexes[name];
+    return nameIndex ? [self childrenWithNameIndex:nameIndex.unsignedIntValue limit:NSUIntegerMax] : @[];
+}
+
+/// 按名字的下标筛选子元素, JBXMLNodeNotFound表示不筛选
+- (NSArray<JBXMLElement *> *)childrenWithNameIndex:(uint32_t)nameIndex limit:(NSUInteger)limit {
+    const JBXMLNode *nodes = self.document.nodes.bytes;
+
+    NSMutableArray *children = [NSMutableArray array];
+    for (uint32_t child = nodes[self.index].firstChild; child != JBXMLNodeNotFound && children.count < limit; child = nodes[child].nextSibling) {
+        if (nameIndex == JBXMLNodeNotFound || nodes[child].name == nameIndex) {
+            [children addObject:[[JBXMLElement alloc] initWithDocument:self.document index:child]];
+        }
+    }
+
+    return [children copy];
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %p, name: %@, attributes: %@, text: %@>", NSStringFromClass([self class]), self, self.name, self.attributes, self.text];
+}
+
+@end
+
+
+#pragma mark - JBXMLDocumentBuilder
+
+/// 边解析边往文档里追加节点
+@interface JBXMLDocumentBuilder : NSObject <NSXMLParserDelegate>
+@property (nonatomic, strong) JBXMLDocument *document;
+/// 还没有结束的元素<节点下标>
+@property (nonatomic, strong) NSMutableData *elementStack;
+/// 每一层一个文本缓冲区, 兄弟元素之间复用
+@property (nonatomic, strong) NSMutableArray <NSMutableString *> *textBuffers;
+@end
+
+@implementation JBXMLDocumentBuilder
+
+- (instancetype)initWithDocument:(JBXMLDocument *)document {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+
+    self.document = document;
+    self.elementStack = [NSMutableData data];
+    self.textBuffers = [NSMutableArray array];
+
+    return self;
+}
+
+- (NSUInteger)depth {
+    return self.elementStack.length / sizeof(uint32_t);
+}
+
+- (uint32_t)internName:(NSString *)name {
+    NSNumber *nameIndex = self.document.nameIndexes[name];
+    if (!nameIndex) {
+        nameIndex = @(self.document.names.count);
+        NSString *internedName = [name copy];
+        [self.document.names addObject:internedName];
+        self.document.nameIndexes[internedName] = nameIndex;
+    }
+
+    return nameIndex.unsignedIntValue;
+}
+
+- (void)parser:(NSXMLParser *)parser didStartElement:(NSString *)elementName namespaceURI:(NSString *)namespaceURI qualifiedName:(NSString *)qName attributes:(NSDictionary<NSString *,NSString *> *)attributeDict {
+    JBXMLDocument *document = self.document;
+    NSUInteger depth = [self depth];
+    uint32_t parent = depth > 0 ? ((const uint32_t *)self.elementStack.bytes)[depth - 1] : JBXMLNodeNotFound;
+    uint32_t index = (uint32_t)(document.nodes.length / sizeof(JBXMLNode));
+
+    JBXMLNode node;
+    node.name = [self internName:elementName];
+    node.parent = parent;
+    node.firstChild = JBXMLNodeNotFound;
+    node.lastChild = JBXMLNodeNotFound;
+    node.nextSibling = JBXMLNodeNotFound;
+    node.firstAttribute = (uint32_t)(document.nodeAttributes.length / sizeof(JBXMLAttribute));
+    node.attributeCount = (uint32_t)attributeDict.count;
+    node.textLocation = 0;
+    node.textLength = 0;
+
+    [attributeDict enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSString *value, BOOL *stop) {
+        JBXMLAttribute attribute;
+        attribute.name = [self internName:key];
+        attribute.valueLocation = (uint32_t)document.textStorage.length;
+        attribute.valueLength = (uint32_t)value.length;
+
+        [document.textStorage appendString:value];
+        [document.nodeAttributes appendBytes:&attribute length:sizeof(attribute)];
+    }];
+
+    [document.nodes appendBytes:&node length:sizeof(node)];
+
+    // 追加以后内存可能搬家, 重新取指针再挂到父节点上
+    if (parent != JBXMLNodeNotFound) {
+        JBXMLNode *nodes = document.nodes.mutableBytes;
+        if (nodes[parent].lastChild != JBXMLNodeNotFound) {
+            nodes[nodes[parent].lastChild].nextSibling = index;
+        } else {
+            nodes[parent].firstChild = index;
+        }
+        nodes[parent].lastChild = index;
+    }
+
+    [self.elementStack appendBytes:&index length:sizeof(index)];
+
+    if (self.textBuffers.count <= depth) {
+        [self.textBuffers addObject:[NSMutableString string]];
+    } else {
+        [self.textBuffers[depth] setString:@""];
+    }
+}
+
+- (void)parser:(NSXMLParser *)parser foundCharacters:(NSString *)string {
+    NSUInteger depth = [self depth];
+    if (depth > 0) {
+        [self.textBuffers[depth - 1] appendString:string];
+    }
+}
+
+- (void)parser:(NSXMLParser *)parser foundCDATA:(NSData *)CDATABlock {
+    NSString *string = [[NSString alloc] initWithData:CDATABlock encoding:NSUTF8StringEncoding];
+    if (string) {
+        [self parser:parser foundCharacters:string];
+    }
+}
+
+- (void)parser:(NSXMLParser *)parser didEndElement:(NSString *)elementName namespaceURI:(NSString *)namespaceURI qualifiedName:(NSString *)qName {
+    NSUInteger depth = [self depth];
+    if (depth == 0) {
+        return;
+    }
+
+    JBXMLDocument *document = self.document;
+    uint32_t index = ((const uint32_t *)self.elementStack.bytes)[depth - 1];
+
+    NSString *text = [self.textBuffers[depth - 1] stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]];
+    if (text.length > 0) {
+        JBXMLNode *nodes = document.nodes.mutableBytes;
+        nodes[index].textLocation = (uint32_t)document.textStorage.length;
+        nodes[index].textLength = (uint32_t)text.length;
+
+        [document.textStorage appendString:text];
+    }
+
+    self.elementStack.length -= sizeof(uint32_t);
+}
+
+@end
+
+
+#pragma mark - JBXMLPathExtractor
+
+/// 编译好的路径
+@interface JBXMLPath : NSObject
+@property (nonatomic, copy) NSString *path;
+/// 每一段的标签名<已经驻留>
+@property (nonatomic, copy) NSArray <NSString *> *steps;
+/// 最后一段是 @xxx 的时候取的属性名
+@property (nonatomic, copy) NSString *attributeName;
+@property (nonatomic, assign, getter = isAbsolute) BOOL absolute;
+@property (nonatomic, strong) NSMutableArray <NSString *> *values;
+@end
+
+@implementation JBXMLPath
+
+- (instancetype)initWithPath:(NSString *)path internedNames:(NSMutableDictionary <NSString *, NSString *> *)internedNames {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+
+    self.path = path;
+    self.absolute = [path hasPrefix:@"/"] && ![path hasPrefix:@"//"];
+    self.values = [NSMutableArray array];
+
+    // 只支持开头的 `//`, 中间的 `//`<任意层级的后代>不支持, 不能当成 `/` 悄悄改变含义
+    NSString *relativePath = [path substringFromIndex:self.isAbsolute ? 1 : ([path hasPrefix:@"//"] ? 2 : 0)];
+    NSMutableArray *steps = [NSMutableArray array];
+    for (NSString *component in [relativePath componentsSeparatedByString:@"/"]) {
+        if (component.length == 0) {
+            return nil;
+        }
+        [steps addObject:JBXMLInternedString(internedNames, component)];
+    }
+
+    if ([steps.lastObject hasPrefix:@"@"]) {
+        self.attributeName = [steps.lastObject substringFromIndex:1];
+        [steps removeLastObject];
+    }
+    self.steps = steps;
+
+    if (steps.count == 0 || (self.attributeName && self.attributeName.length == 0)) {
+        return nil;
+    }
+
+    return self;
+}
+
+/// 从栈顶往下逐段比较, 名字都是驻留过的, 直接比较指针
+- (BOOL)matchesElementStack:(NSArray <NSString *> *)elementStack wildcard:(NSString *)wildcard {
+    NSUInteger stepCount = self.steps.count;
+    NSUInteger depth = elementStack.count;
+    if (stepCount == 0 || stepCount > depth || (self.isAbsolute && stepCount != depth)) {
+        return NO;
+    }
+
+    for (NSUInteger i = 1; i <= stepCount; i++) {
+        NSString *step = self.steps[stepCount - i];
+        if (step != wildcard && step != elementStack[depth - i]) {
+            return NO;
+        }
+    }
+
+    return YES;
+}
+
+@end
+
+/// 正在收集文本的匹配
+@interface JBXMLPathCapture : NSObject
+@property (nonatomic, strong) JBXMLPath *path;
+@property (nonatomic, assign) NSUInteger depth;
+/// 元素开始的时候在values里占好的位置, 嵌套的匹配也能保持文档顺序
+@property (nonatomic, assign) NSUInteger index;
+@property (nonatomic, strong) NSMutableString *text;
+@end
+
+@implementation JBXMLPathCapture
+@end
+
+/// 只记录当前元素的路径, 匹配上的字段才保存, 不建立节点树
+@interface JBXMLPathExtractor : NSObject <NSXMLParserDelegate>
+@property (nonatomic, strong) NSMutableDictionary <NSString *, NSString *> *internedNames;
+@property (nonatomic, copy) NSString *wildcard;
+@property (nonatomic, copy) NSArray <JBXMLPath *> *paths;
+@property (nonatomic, strong) NSMutableArray <NSString *> *elementStack;
+@property (nonatomic, strong) NSMutableArray <JBXMLPathCapture *> *captures;
+@end
+
+@implementation JBXMLPathExtractor
+
+- (instancetype)initWithPaths:(NSArray <NSString *> *)paths error:(NSError * __autoreleasing *)error {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+
+    self.internedNames = [NSMutableDictionary dictionary];
+    self.wildcard = JBXMLInternedString(self.internedNames, @"*");
+
+    NSMutableArray *compiledPaths = [NSMutableArray arrayWithCapacity:paths.count];
+    for (NSString *path in paths) {
+        JBXMLPath *compiledPath = [[JBXMLPath alloc] initWithPath:path internedNames:self.internedNames];
+        if (!compiledPath) {
+            if (error) {
+                NSDictionary *userInfo = @{NSLocalizedDescriptionKey: [NSString stringWithFormat:NSLocalizedStringFromTable(@"Unsupported XML path: %@", @"JBNetworking", nil), path]};
+                *error = [NSError errorWithDomain:JBXMLDocumentErrorDomain code:NSFormattingError userInfo:userInfo];
+            }
+            return nil;
+        }
+        [compiledPaths addObject:compiledPath];
+    }
+    self.paths = compiledPaths;
+
+    self.elementStack = [NSMutableArray array];
+    self.captures = [NSMutableArray array];
+
+    return self;
+}
+
+- (NSDictionary <NSString *, NSArray <NSString *> *> *)values {
+    NSMutableDictionary *values = [NSMutableDictionary dictionaryWithCapacity:self.paths.count];
+    for (JBXMLPath *path in self.paths) {
+        values[path.path] = [path.values copy];
+    }
+
+    return [values copy];
+}
+
+- (void)parser:(NSXMLParser *)parser didStartElement:(NSString *)elementName namespaceURI:(NSString *)namespaceURI qualifiedName:(NSString *)qName attributes:(NSDictionary<NSString *,NSString *> *)attributeDict {
+    [self.elementStack addObject:JBXMLInternedString(self.internedNames, elementName)];
+
+    for (JBXMLPath *path in self.paths) {
+        if (![path matchesElementStack:self.elementStack wildcard:self.wildcard]) {
+            continue;
+        }
+
+        if (path.attributeName) {
+            NSString *value = attributeDict[path.attributeName];
+            if (value) {
+                [path.values addObject:value];
+            }
+        } else {
+            JBXMLPathCapture *capture = [[JBXMLPathCapture alloc] init];
+            capture.path = path;
+            capture.depth = self.elementStack.count;
+            capture.index = path.values.count;
+            capture.text = [NSMutableString string];
+            [path.values addObject:@""];
+            [self.captures addObject:capture];
+        }
+    }
+}
+
+- (void)parser:(NSXMLParser *)parser foundCharacters:(NSString *)string {
+    for (JBXMLPathCapture *capture in self.captures) {
+        [capture.text appendString:string];
+    }
+}
+
+- (void)parser:(NSXMLParser *)parser foundCDATA:(NSData *)CDATABlock {
+    if (self.captures.count == 0) {
+        return;
+    }
+
+    NSString *string = [[NSString alloc] initWithData:CDATABlock encoding:NSUTF8StringEncoding];
+    if (string) {
+        [self parser:parser foundCharacters:string];
+    }
+}
+
+- (void)parser:(NSXMLParser *)parser didEndElement:(NSString *)elementName namespaceURI:(NSString *)namespaceURI qualifiedName:(NSString *)qName {
+    NSUInteger depth = self.elementStack.count;
+
+    // 匹配按深度依次入栈, 结束的元素对应的匹配一定在最后面
+    while (self.captures.lastObject.depth == depth && depth > 0) {
+        JBXMLPathCapture *capture = self.captures.lastObject;
+        [capture.path.values replaceObjectAtIndex:capture.index withObject:[capture.text stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceAndNewlineCharacterSet]]];
+        [self.captures removeLastObject];
+    }
+
+    if (depth > 0) {
+        [self.elementStack removeLastObject];
+    }
+}
+
+@end
+
+
+#pragma mark - JBXMLDocument
+
+@implementation JBXMLDocument
+
+- (instancetype)init {
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+
+    self.nodes = [NSMutableData data];
+    self.nodeAttributes = [NSMutableData data];
+    self.names = [NSMutableArray array];
+    self.nameIndexes = [NSMutableDictionary dictionary];
+    self.textStorage = [NSMutableString string];
+
+    return self;
+}
+
++ (instancetype)documentWithData:(NSData *)data error:(NSError *__autoreleasing *)error {
+    JBXMLDocument *document = [[self alloc] init];
+    JBXMLDocumentBuilder *builder = [[JBXMLDocumentBuilder alloc] initWithDocument:document];
+
+    NSXMLParser *parser = [[NSXMLParser alloc] initWithData:data];
+    parser.delegate = builder;
+    if (![parser parse]) {
+        if (error) {
+            *error = parser.parserError;
+        }
+        return nil;
+    }
+
+    return document;
+}
+
++ (NSDictionary<NSString *,NSArray<NSString *> *> *)valuesForPaths:(NSArray<NSString *> *)paths inData:(NSData *)data error:(NSError *__autoreleasing *)error {
+    JBXMLPathExtractor *extractor = [[JBXMLPathExtractor alloc] initWithPaths:paths error:error];
+    if (!extractor) {
+        return nil;
+    }
+
+    NSXMLParser *parser = [[NSXMLParser alloc] initWithData:data];
+    parser.delegate = extractor;
+    if (![parser parse]) {
+        if (error) {
+            *error = parser.parserError;
+        }
+        return nil;
+    }
+
+    return [extractor values];
+}
+
+- (NSUInteger)elementCount {
+    return self.nodes.length / sizeof(JBXMLNode);
+}
+
+- (JBXMLElement *)rootElement {
+    return self.elementCount > 0 ? [[JBXMLElement alloc] initWithDocument:self index:0] : nil;
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@: %p, rootElement: %@, elementCount: %lu>", NSStringFromClass([self class]), self, self.rootElement.name, (unsigned long)self.elementCount];
+}
+
+@end